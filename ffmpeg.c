@@ -138,6 +138,13 @@ static uint8_t *subtitle_out;
 #if HAVE_PTHREADS
 /* signal to input threads that they should exit; set by the main thread */
 static int transcoding_finished;
+
+/* with -pipeline, the transcoding state is shared by the main thread and the
+ * decoder and encoder threads; it is protected by pipeline_lock, which is
+ * only released while reading, decoding, encoding or waiting */
+#define PIPELINE_QUEUE_SIZE 8
+static pthread_mutex_t pipeline_lock;
+static int pipeline_running;
 #endif
 
 #define DEFAULT_PASS_LOGFILENAME_PREFIX "ffmpeg2pass"
@@ -163,6 +170,23 @@ static int restore_tty;
 #endif
 
 static void free_input_threads(void);
+static void free_pipeline_threads(void);
+
+static void lock_pipeline(void)
+{
+#if HAVE_PTHREADS
+    if (pipeline_running)
+        pthread_mutex_lock(&pipeline_lock);
+#endif
+}
+
+static void unlock_pipeline(void)
+{
+#if HAVE_PTHREADS
+    if (pipeline_running)
+        pthread_mutex_unlock(&pipeline_lock);
+#endif
+}
 
 
 /* sub2video hack:
@@ -676,7 +700,7 @@ static void do_audio_out(AVFormatContext *s, OutputStream *ost,
 {
     AVCodecContext *enc = ost->st->codec;
     AVPacket pkt;
-    int got_packet = 0;
+    int got_packet = 0, ret;
 
     av_init_packet(&pkt);
     pkt.data = NULL;
@@ -691,7 +715,10 @@ static void do_audio_out(AVFormatContext *s, OutputStream *ost,
 
     av_assert0(pkt.size || !pkt.data);
     update_benchmark(NULL);
-    if (avcodec_encode_audio2(enc, &pkt, frame, &got_packet) < 0) {
+    unlock_pipeline();
+    ret = avcodec_encode_audio2(enc, &pkt, frame, &got_packet);
+    lock_pipeline();
+    if (ret < 0) {
         av_log(NULL, AV_LOG_FATAL, "Audio encoding failed (avcodec_encode_audio2)\n");
         exit(1);
     }
@@ -944,7 +971,9 @@ static void do_video_out(AVFormatContext *s,
         }
 
         update_benchmark(NULL);
+        unlock_pipeline();
         ret = avcodec_encode_video2(enc, &pkt, in_picture, &got_packet);
+        lock_pipeline();
         update_benchmark("encode_video %d.%d", ost->file_index, ost->index);
         if (ret < 0) {
             av_log(NULL, AV_LOG_FATAL, "Video encoding failed\n");
@@ -1032,6 +1061,74 @@ static void do_video_stats(OutputStream *ost, int frame_size)
     }
 }
 
+static void encode_filtered_frame(OutputStream *ost, AVFrame *frame)
+{
+    OutputFile *of = output_files[ost->file_index];
+
+    switch (ost->filter->filter->inputs[0]->type) {
+    case AVMEDIA_TYPE_VIDEO:
+        if (!ost->frame_aspect_ratio.num)
+            ost->st->codec->sample_aspect_ratio = frame->sample_aspect_ratio;
+
+        do_video_out(of->ctx, ost, frame);
+        break;
+    case AVMEDIA_TYPE_AUDIO:
+        if (!(ost->st->codec->codec->capabilities & CODEC_CAP_PARAM_CHANGE) &&
+            ost->st->codec->channels != av_frame_get_channels(frame)) {
+            av_log(NULL, AV_LOG_ERROR,
+                   "Audio filter graph output is not normalized and encoder does not support parameter changes\n");
+            break;
+        }
+        do_audio_out(of->ctx, ost, frame);
+        break;
+    default:
+        // TODO support subtitle filters
+        av_assert0(0);
+    }
+}
+
+#if HAVE_PTHREADS
+static void *encoder_thread(void *arg)
+{
+    OutputStream *ost = arg;
+    AVFrame *frame;
+
+    pthread_mutex_lock(&pipeline_lock);
+    for (;;) {
+        while (!av_fifo_size(ost->frame_queue) && !ost->queue_finished)
+            pthread_cond_wait(&ost->queue_cond, &pipeline_lock);
+        if (!av_fifo_size(ost->frame_queue))
+            break;
+
+        av_fifo_generic_read(ost->frame_queue, &frame, sizeof(frame), NULL);
+        pthread_cond_signal(&ost->queue_cond);
+
+        encode_filtered_frame(ost, frame);
+        av_frame_free(&frame);
+    }
+    pthread_mutex_unlock(&pipeline_lock);
+
+    return NULL;
+}
+
+/* move the frame to the queue of the encoder thread, waiting for space */
+static int queue_encoder_frame(OutputStream *ost, AVFrame *frame)
+{
+    AVFrame *queued = av_frame_alloc();
+
+    if (!queued)
+        return AVERROR(ENOMEM);
+    av_frame_move_ref(queued, frame);
+
+    while (!av_fifo_space(ost->frame_queue))
+        pthread_cond_wait(&ost->queue_cond, &pipeline_lock);
+    av_fifo_generic_write(ost->frame_queue, &queued, sizeof(queued), NULL);
+    pthread_cond_signal(&ost->queue_cond);
+
+    return 0;
+}
+#endif
+
 /**
  * Get and encode new output from any of the filtergraphs, without causing
  * activity.
@@ -1081,30 +1178,15 @@ static int reap_filters(void)
             //if (ost->source_index >= 0)
             //    *filtered_frame= *input_streams[ost->source_index]->decoded_frame; //for me_threshold
 
-
-            switch (ost->filter->filter->inputs[0]->type) {
-            case AVMEDIA_TYPE_VIDEO:
-                filtered_frame->pts = frame_pts;
-                if (!ost->frame_aspect_ratio.num)
-                    ost->st->codec->sample_aspect_ratio = filtered_frame->sample_aspect_ratio;
-
-                do_video_out(of->ctx, ost, filtered_frame);
-                break;
-            case AVMEDIA_TYPE_AUDIO:
-                filtered_frame->pts = frame_pts;
-                if (!(ost->st->codec->codec->capabilities & CODEC_CAP_PARAM_CHANGE) &&
-                    ost->st->codec->channels != av_frame_get_channels(filtered_frame)) {
-                    av_log(NULL, AV_LOG_ERROR,
-                           "Audio filter graph output is not normalized and encoder does not support parameter changes\n");
-                    break;
-                }
-                do_audio_out(of->ctx, ost, filtered_frame);
-                break;
-            default:
-                // TODO support subtitle filters
-                av_assert0(0);
+            filtered_frame->pts = frame_pts;
+#if HAVE_PTHREADS
+            if (ost->frame_queue) {
+                if ((ret = queue_encoder_frame(ost, filtered_frame)) < 0)
+                    return ret;
+                continue;
             }
-
+#endif
+            encode_filtered_frame(ost, filtered_frame);
             av_frame_unref(filtered_frame);
         }
     }
@@ -1502,7 +1584,9 @@ static int decode_audio(InputStream *ist, AVPacket *pkt, int *got_output)
     decoded_frame = ist->decoded_frame;
 
     update_benchmark(NULL);
+    unlock_pipeline();
     ret = avcodec_decode_audio4(avctx, decoded_frame, got_output, pkt);
+    lock_pipeline();
     update_benchmark("decode_audio %d.%d", ist->file_index, ist->st->index);
 
     if (ret >= 0 && avctx->sample_rate <= 0) {
@@ -1642,8 +1726,10 @@ static int decode_video(InputStream *ist, AVPacket *pkt, int *got_output)
     pkt->dts  = av_rescale_q(ist->dts, AV_TIME_BASE_Q, ist->st->time_base);
 
     update_benchmark(NULL);
+    unlock_pipeline();
     ret = avcodec_decode_video2(ist->st->codec,
                                 decoded_frame, got_output, pkt);
+    lock_pipeline();
     update_benchmark("decode_video %d.%d", ist->file_index, ist->st->index);
 
     if (*got_output || ret<0 || pkt->size)
@@ -1921,6 +2007,73 @@ static int output_packet(InputStream *ist, const AVPacket *pkt)
     return 0;
 }
 
+static void process_input_packet(InputStream *ist, const AVPacket *pkt)
+{
+    int ret = output_packet(ist, pkt);
+
+    if (ret < 0) {
+        char buf[128];
+        av_strerror(ret, buf, sizeof(buf));
+        av_log(NULL, AV_LOG_ERROR, "Error while decoding stream #%d:%d: %s\n",
+                ist->file_index, ist->st->index, buf);
+        if (exit_on_error)
+            exit(1);
+    }
+}
+
+#if HAVE_PTHREADS
+static void *decoder_thread(void *arg)
+{
+    InputStream *ist = arg;
+    AVPacket pkt;
+
+    pthread_mutex_lock(&pipeline_lock);
+    for (;;) {
+        while (!av_fifo_size(ist->packet_queue) && !ist->flush_requested &&
+               !ist->queue_finished)
+            pthread_cond_wait(&ist->queue_cond, &pipeline_lock);
+
+        if (av_fifo_size(ist->packet_queue)) {
+            av_fifo_generic_read(ist->packet_queue, &pkt, sizeof(pkt), NULL);
+            pthread_cond_signal(&ist->queue_cond);
+
+            process_input_packet(ist, &pkt);
+            av_free_packet(&pkt);
+        } else if (ist->flush_requested) {
+            ist->flush_requested = 0;
+            output_packet(ist, NULL);
+        } else
+            break;
+    }
+    pthread_mutex_unlock(&pipeline_lock);
+
+    return NULL;
+}
+
+/* pass the packet to the decoder thread, waiting for space in its queue */
+static void queue_decoder_packet(InputStream *ist, AVPacket *pkt)
+{
+    while (!av_fifo_space(ist->packet_queue))
+        pthread_cond_wait(&ist->queue_cond, &pipeline_lock);
+
+    av_dup_packet(pkt);
+    av_fifo_generic_write(ist->packet_queue, pkt, sizeof(*pkt), NULL);
+    pthread_cond_signal(&ist->queue_cond);
+}
+#endif
+
+static void flush_decoder(InputStream *ist)
+{
+#if HAVE_PTHREADS
+    if (ist->packet_queue) {
+        ist->flush_requested = 1;
+        pthread_cond_signal(&ist->queue_cond);
+        return;
+    }
+#endif
+    output_packet(ist, NULL);
+}
+
 static void print_sdp(void)
 {
     char sdp[16384];
@@ -2814,10 +2967,114 @@ static int get_input_packet_mt(InputFile *f, AVPacket *pkt)
 
     return ret;
 }
+
+static void free_pipeline_threads(void)
+{
+    int i;
+
+    if (!pipeline_running)
+        return;
+
+    /* drain the decoders first, they may still feed the encoders */
+    for (i = 0; i < nb_input_streams; i++) {
+        InputStream *ist = input_streams[i];
+        if (ist->packet_queue) {
+            ist->queue_finished = 1;
+            pthread_cond_signal(&ist->queue_cond);
+        }
+    }
+    pthread_mutex_unlock(&pipeline_lock);
+    for (i = 0; i < nb_input_streams; i++)
+        if (input_streams[i]->packet_queue)
+            pthread_join(input_streams[i]->decoder_thread, NULL);
+
+    pthread_mutex_lock(&pipeline_lock);
+    for (i = 0; i < nb_output_streams; i++) {
+        OutputStream *ost = output_streams[i];
+        if (ost->frame_queue) {
+            ost->queue_finished = 1;
+            pthread_cond_signal(&ost->queue_cond);
+        }
+    }
+    pthread_mutex_unlock(&pipeline_lock);
+    for (i = 0; i < nb_output_streams; i++)
+        if (output_streams[i]->frame_queue)
+            pthread_join(output_streams[i]->encoder_thread, NULL);
+
+    pipeline_running = 0;
+
+    for (i = 0; i < nb_input_streams; i++) {
+        InputStream *ist = input_streams[i];
+        if (ist->packet_queue) {
+            av_fifo_free(ist->packet_queue);
+            ist->packet_queue = NULL;
+            pthread_cond_destroy(&ist->queue_cond);
+        }
+    }
+    for (i = 0; i < nb_output_streams; i++) {
+        OutputStream *ost = output_streams[i];
+        if (ost->frame_queue) {
+            av_fifo_free(ost->frame_queue);
+            ost->frame_queue = NULL;
+            pthread_cond_destroy(&ost->queue_cond);
+        }
+    }
+    pthread_mutex_destroy(&pipeline_lock);
+}
+
+static int init_pipeline_threads(void)
+{
+    int i, ret;
+
+    pthread_mutex_init(&pipeline_lock, NULL);
+    pthread_mutex_lock(&pipeline_lock);
+    pipeline_running = 1;
+
+    for (i = 0; i < nb_input_streams; i++) {
+        InputStream *ist = input_streams[i];
+        enum AVMediaType type = ist->st->codec->codec_type;
+
+        if (!ist->decoding_needed ||
+            (type != AVMEDIA_TYPE_AUDIO && type != AVMEDIA_TYPE_VIDEO))
+            continue;
+
+        if (!(ist->packet_queue = av_fifo_alloc(PIPELINE_QUEUE_SIZE * sizeof(AVPacket))))
+            return AVERROR(ENOMEM);
+        pthread_cond_init(&ist->queue_cond, NULL);
+
+        if ((ret = pthread_create(&ist->decoder_thread, NULL, decoder_thread, ist))) {
+            av_fifo_free(ist->packet_queue);
+            ist->packet_queue = NULL;
+            pthread_cond_destroy(&ist->queue_cond);
+            return AVERROR(ret);
+        }
+    }
+
+    for (i = 0; i < nb_output_streams; i++) {
+        OutputStream *ost = output_streams[i];
+
+        if (!ost->encoding_needed || !ost->filter)
+            continue;
+
+        if (!(ost->frame_queue = av_fifo_alloc(PIPELINE_QUEUE_SIZE * sizeof(AVFrame*))))
+            return AVERROR(ENOMEM);
+        pthread_cond_init(&ost->queue_cond, NULL);
+
+        if ((ret = pthread_create(&ost->encoder_thread, NULL, encoder_thread, ost))) {
+            av_fifo_free(ost->frame_queue);
+            ost->frame_queue = NULL;
+            pthread_cond_destroy(&ost->queue_cond);
+            return AVERROR(ret);
+        }
+    }
+    return 0;
+}
 #endif
 
 static int get_input_packet(InputFile *f, AVPacket *pkt)
 {
+    int ret;
+
     if (f->rate_emu) {
         int i;
         for (i = 0; i < f->nb_streams; i++) {
@@ -2833,7 +3090,10 @@ static int get_input_packet(InputFile *f, AVPacket *pkt)
     if (nb_input_files > 1)
         return get_input_packet_mt(f, pkt);
 #endif
-    return av_read_frame(f->ctx, pkt);
+    unlock_pipeline();
+    ret = av_read_frame(f->ctx, pkt);
+    lock_pipeline();
+    return ret;
 }
 
 static int got_eagain(void)
@@ -2887,7 +3147,7 @@ static int process_input(int file_index)
         for (i = 0; i < ifile->nb_streams; i++) {
             ist = input_streams[ifile->ist_index + i];
             if (ist->decoding_needed)
-                output_packet(ist, NULL);
+                flush_decoder(ist);
 
             /* mark all outputs that don't go through lavfi as finished */
             for (j = 0; j < nb_output_streams; j++) {
@@ -3044,15 +3304,13 @@ static int process_input(int file_index)
 
     sub2video_heartbeat(ist, pkt.pts);
 
-    ret = output_packet(ist, &pkt);
-    if (ret < 0) {
-        char buf[128];
-        av_strerror(ret, buf, sizeof(buf));
-        av_log(NULL, AV_LOG_ERROR, "Error while decoding stream #%d:%d: %s\n",
-                ist->file_index, ist->st->index, buf);
-        if (exit_on_error)
-            exit(1);
+#if HAVE_PTHREADS
+    if (ist->packet_queue) {
+        queue_decoder_packet(ist, &pkt);
+        return 0;
     }
+#endif
+    process_input_packet(ist, &pkt);
 
 discard_packet:
     av_free_packet(&pkt);
@@ -3123,7 +3381,9 @@ static int transcode_step(void)
     if (!ost) {
         if (got_eagain()) {
             reset_eagain();
+            unlock_pipeline();
             av_usleep(10000);
+            lock_pipeline();
             return 0;
         }
         av_log(NULL, AV_LOG_VERBOSE, "No more inputs to read from, finishing.\n");
@@ -3176,6 +3436,8 @@ static int transcode(void)
 #if HAVE_PTHREADS
     if ((ret = init_input_threads()) < 0)
         goto fail;
+    if (do_pipeline && (ret = init_pipeline_threads()) < 0)
+        goto fail;
 #endif
 
     while (!received_sigterm) {
@@ -3212,9 +3474,12 @@ static int transcode(void)
     for (i = 0; i < nb_input_streams; i++) {
         ist = input_streams[i];
         if (!input_files[ist->file_index]->eof_reached && ist->decoding_needed) {
-            output_packet(ist, NULL);
+            flush_decoder(ist);
         }
     }
+#if HAVE_PTHREADS
+    free_pipeline_threads();
+#endif
     flush_encoders();
 
     term_exit();
@@ -3251,6 +3516,7 @@ static int transcode(void)
  fail:
 #if HAVE_PTHREADS
     free_input_threads();
+    free_pipeline_threads();
 #endif
 
     if (output_streams) {
@@ -273,6 +273,15 @@ typedef struct InputStream {
     int        nb_filters;
 
     int reinit_filters;
+
+#if HAVE_PTHREADS
+    /* with -pipeline, packets are decoded by a thread of their own */
+    pthread_t decoder_thread;
+    pthread_cond_t queue_cond;  /* signaled when packet_queue or the flags below change */
+    AVFifoBuffer *packet_queue; /* demuxed packets waiting for the decoder thread */
+    int flush_requested;        /* flush the decoder once packet_queue is empty */
+    int queue_finished;         /* no more packets will be queued */
+#endif
 } InputStream;
 
 typedef struct InputFile {
@@ -367,6 +376,14 @@ typedef struct OutputStream {
     int copy_prior_start;
 
     int keep_pix_fmt;
+
+#if HAVE_PTHREADS
+    /* with -pipeline, filtered frames are encoded by a thread of their own */
+    pthread_t encoder_thread;
+    pthread_cond_t queue_cond;  /* signaled when frame_queue or queue_finished change */
+    AVFifoBuffer *frame_queue;  /* filtered frames waiting for the encoder thread */
+    int queue_finished;         /* no more frames will be queued */
+#endif
 } OutputStream;
 
 typedef struct OutputFile {
@@ -410,6 +427,7 @@ extern int do_pkt_dump;
 extern int copy_ts;
 extern int copy_tb;
 extern int debug_ts;
+extern int do_pipeline;
 extern int exit_on_error;
 extern int print_stats;
 extern int qp_hist;
@@ -79,6 +79,7 @@ int do_pkt_dump       = 0;
 int copy_ts           = 0;
 int copy_tb           = -1;
 int debug_ts          = 0;
+int do_pipeline       = 0;
 int exit_on_error     = 0;
 int print_stats       = -1;
 int qp_hist           = 0;
@@ -2694,6 +2695,8 @@ const OptionDef options[] = {
         "extract an attachment into a file", "filename" },
     { "debug_ts",       OPT_BOOL | OPT_EXPERT,                       { &debug_ts },
         "print timestamp debugging info" },
+    { "pipeline",       OPT_BOOL | OPT_EXPERT,                       { &do_pipeline },
+        "decode and encode each stream in a thread of its own" },
 
     /* video options */
     { "vframes",      OPT_VIDEO | HAS_ARG  | OPT_PERFILE | OPT_OUTPUT,           { .func_arg = opt_video_frames },
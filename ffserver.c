@@ -43,6 +43,7 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
+#include "libavutil/buffer.h"
 #include "libavutil/lfg.h"
 #include "libavutil/dict.h"
 #include "libavutil/intreadwrite.h"
@@ -66,6 +67,9 @@
 #if HAVE_DLFCN_H
 #include <dlfcn.h>
 #endif
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
 
 #include "cmdutils.h"
 
@@ -128,6 +132,10 @@ typedef struct {
 /* context associated with one connection */
 typedef struct HTTPContext {
     enum HTTPState state;
+    struct HTTPWorker *worker; /* worker thread serving the connection, NULL for the main loop */
+    int to_worker;             /* hand the connection over to a worker thread */
+    unsigned feed_data_gen;    /* feed generations seen when waiting for the feed */
+    unsigned feed_end_gen;
     int fd; /* socket file descriptor */
     struct sockaddr_in from_addr; /* origin */
     struct pollfd *poll_entry; /* used when polling */
@@ -155,6 +163,9 @@ typedef struct HTTPContext {
     int64_t cur_clock;           /* current clock reference value in us */
     /* output format handling */
     struct FFStream *stream;
+    struct SharedMux *mux;       /* shared muxer the data comes from, if any */
+    int64_t mux_pos;             /* index of the next chunk to send */
+    AVBufferRef *chunk;          /* chunk being sent */
     /* -1 is invalid stream */
     int feed_streams[MAX_STREAMS]; /* index of streams in the feed */
     int switch_feed_streams[MAX_STREAMS]; /* index of streams in the feed */
@@ -257,6 +268,9 @@ typedef struct FFStream {
     int64_t feed_max_size;      /* maximum storage size, zero means unlimited */
     int64_t feed_write_index;   /* current write position in feed (it wraps around) */
     int64_t feed_size;          /* current size of feed */
+    unsigned feed_data_gen;     /* incremented when a packet is written to the feed */
+    unsigned feed_end_gen;      /* incremented when the feeder disconnects */
+    struct SharedMux *mux;      /* muxer shared by the HTTP connections */
     struct FFStream *next_feed;
 } FFStream;
 
@@ -265,6 +279,43 @@ typedef struct FeedData {
     float avg_frame_size;   /* frame size averaged over last frames with exponential mean */
 } FeedData;
 
+/* number of muxed packets kept for the connections sharing a muxer */
+#define SHARED_MUX_CHUNKS 512
+
+/* output of a live stream muxed once for all its HTTP connections;
+   nb_users is protected by server_lock, the rest by lock */
+typedef struct SharedMux {
+#if HAVE_PTHREADS
+    pthread_mutex_t lock;       /* held while reading the feed and muxing,
+                                   never together with another lock */
+#endif
+    AVFormatContext *fmt_in;    /* feed reader */
+    AVFormatContext fmt_ctx;
+    AVBufferRef *header;        /* data written by avformat_write_header() */
+    AVBufferRef *trailer;       /* data written by av_write_trailer() */
+    int finished;               /* the trailer has been written */
+    AVBufferRef *chunks[SHARED_MUX_CHUNKS]; /* ring of muxed packets */
+    uint8_t key[SHARED_MUX_CHUNKS];         /* chunk is a sync point */
+    int64_t nb_chunks;          /* number of packets muxed so far */
+    unsigned feed_end_gen;      /* feed generation the muxer was opened at */
+    int nb_users;
+} SharedMux;
+
+/* thread serving HTTP stream connections handed over by the main loop */
+typedef struct HTTPWorker {
+#if HAVE_PTHREADS
+    pthread_t thread;
+    pthread_mutex_t lock;     /* protects first_ctx against the status page,
+                                 taken after server_lock if both are needed */
+#endif
+    int wake_fds[2];          /* written to interrupt the poll() of the worker */
+    HTTPContext *first_ctx;   /* connections served by the worker, only changed by it */
+    HTTPContext *new_ctx;     /* connections handed over, protected by server_lock */
+    int nb_conns;             /* protected by server_lock */
+    int64_t cur_time;
+    struct pollfd *poll_table;
+} HTTPWorker;
+
 static struct sockaddr_in my_http_addr;
 static struct sockaddr_in my_rtsp_addr;
 
@@ -275,6 +326,9 @@ static FFStream *first_stream; /* contains all streams, including feeds */
 
 static void new_connection(int server_fd, int is_rtsp);
 static void close_connection(HTTPContext *c);
+static void close_input_stream(AVFormatContext **ps);
+static void free_output_streams(AVFormatContext *ctx);
+static void release_shared_mux(HTTPContext *c);
 
 /* HTTP handling */
 static int handle_connection(HTTPContext *c);
@@ -282,6 +336,8 @@ static int http_parse_request(HTTPContext *c);
 static int http_send_data(HTTPContext *c);
 static void compute_status(HTTPContext *c);
 static int open_input_stream(HTTPContext *c, const char *info);
+static int can_share_mux(FFStream *stream);
+static int join_shared_mux(HTTPContext *c);
 static int http_start_receive_data(HTTPContext *c);
 static int http_receive_data(HTTPContext *c);
 
@@ -324,6 +380,31 @@ static uint64_t current_bandwidth;
 
 static int64_t cur_time;           // Making this global saves on passing it around everywhere
 
+static int nb_workers;
+static HTTPWorker *workers;
+
+#if HAVE_PTHREADS
+/* protects the state shared between the main loop and the workers:
+ * connection and bandwidth counters, stream statistics and feed state.
+ * Lock order: a worker lock may be taken while server_lock is held, never
+ * the reverse. A SharedMux lock is always taken alone, so that the slow
+ * reading and muxing of the feed never holds up the other locks. */
+static pthread_mutex_t server_lock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK_SERVER()   pthread_mutex_lock(&server_lock)
+#define UNLOCK_SERVER() pthread_mutex_unlock(&server_lock)
+#define LOCK_MUX(mux)   pthread_mutex_lock(&(mux)->lock)
+#define UNLOCK_MUX(mux) pthread_mutex_unlock(&(mux)->lock)
+#define LOCK_WORKER(w)   pthread_mutex_lock(&(w)->lock)
+#define UNLOCK_WORKER(w) pthread_mutex_unlock(&(w)->lock)
+#else
+#define LOCK_SERVER()
+#define UNLOCK_SERVER()
+#define LOCK_MUX(mux)
+#define UNLOCK_MUX(mux)
+#define LOCK_WORKER(w)
+#define UNLOCK_WORKER(w)
+#endif
+
 static AVLFG random_state;
 
 static FILE *logfile = NULL;
@@ -458,19 +539,32 @@ static void log_connection(HTTPContext *c)
              c->protocol, (c->http_error ? c->http_error : 200), c->data_count);
 }
 
-static void update_datarate(DataRateData *drd, int64_t count)
+/* return the time of the event loop the connection is handled in */
+static int64_t conn_time(HTTPContext *c)
+{
+    return c->worker ? c->worker->cur_time : cur_time;
+}
+
+static void update_datarate(DataRateData *drd, int64_t count, int64_t now)
 {
     if (!drd->time1 && !drd->count1) {
-        drd->time1 = drd->time2 = cur_time;
+        drd->time1 = drd->time2 = now;
         drd->count1 = drd->count2 = count;
-    } else if (cur_time - drd->time2 > 5000) {
+    } else if (now - drd->time2 > 5000) {
         drd->time1 = drd->time2;
         drd->count1 = drd->count2;
-        drd->time2 = cur_time;
+        drd->time2 = now;
         drd->count2 = count;
     }
 }
 
+static void add_bytes_served(FFStream *stream, int len)
+{
+    LOCK_SERVER();
+    stream->bytes_served += len;
+    UNLOCK_SERVER();
+}
+
 /* In bytes per second */
 static int compute_datarate(DataRateData *drd, int64_t count)
 {
@@ -630,10 +724,198 @@ static void start_multicast(void)
 }
 
 /* main loop of the http server */
+/* add the socket of a connection to the poll table if its state needs it */
+static struct pollfd *add_poll_entry(HTTPContext *c, struct pollfd *poll_entry,
+                                     int *delay)
+{
+    int fd = c->fd;
+
+    switch(c->state) {
+    case HTTPSTATE_SEND_HEADER:
+    case RTSPSTATE_SEND_REPLY:
+    case RTSPSTATE_SEND_PACKET:
+        c->poll_entry = poll_entry;
+        poll_entry->fd = fd;
+        poll_entry->events = POLLOUT;
+        poll_entry++;
+        break;
+    case HTTPSTATE_SEND_DATA_HEADER:
+    case HTTPSTATE_SEND_DATA:
+    case HTTPSTATE_SEND_DATA_TRAILER:
+        if (!c->is_packetized) {
+            /* for TCP, we output as much as we can (may need to put a limit) */
+            c->poll_entry = poll_entry;
+            poll_entry->fd = fd;
+            poll_entry->events = POLLOUT;
+            poll_entry++;
+        } else {
+            /* when ffserver is doing the timing, we work by
+               looking at which packet need to be sent every
+               10 ms */
+            *delay = FFMIN(*delay, 10); /* one tick wait XXX: 10 ms assumed */
+        }
+        break;
+    case HTTPSTATE_WAIT_REQUEST:
+    case HTTPSTATE_RECEIVE_DATA:
+    case HTTPSTATE_WAIT_FEED:
+    case RTSPSTATE_WAIT_REQUEST:
+        /* need to catch errors */
+        c->poll_entry = poll_entry;
+        poll_entry->fd = fd;
+        poll_entry->events = POLLIN;/* Maybe this will work */
+        poll_entry++;
+        break;
+    default:
+        c->poll_entry = NULL;
+        break;
+    }
+    return poll_entry;
+}
+
+/* interrupt the poll() of the workers, e.g. when new feed data is available */
+static void wake_workers(void)
+{
+    int i;
+
+    for (i = 0; i < nb_workers; i++)
+        if (write(workers[i].wake_fds[1], "", 1) < 0) {
+            /* the pipe is full, so the worker is being woken up anyway */
+        }
+}
+
+/* move a stream connection from the main loop to the least busy worker */
+static void hand_over_connection(HTTPContext *c)
+{
+    HTTPWorker *w = &workers[0];
+    HTTPContext **cp;
+    int i;
+
+    for (cp = &first_http_ctx; *cp != c; cp = &(*cp)->next)
+        ;
+    *cp = c->next;
+    c->to_worker  = 0;
+    c->poll_entry = NULL;
+
+    LOCK_SERVER();
+    for (i = 1; i < nb_workers; i++)
+        if (workers[i].nb_conns < w->nb_conns)
+            w = &workers[i];
+    c->worker  = w;
+    c->next    = w->new_ctx;
+    w->new_ctx = c;
+    w->nb_conns++;
+    UNLOCK_SERVER();
+
+    if (write(w->wake_fds[1], "", 1) < 0) {
+        /* the pipe is full, so the worker is being woken up anyway */
+    }
+}
+
+#if HAVE_PTHREADS
+static void *http_worker(void *arg)
+{
+    HTTPWorker *w = arg;
+    struct pollfd *poll_entry;
+    HTTPContext *c, *c_next;
+    char buf[64];
+    int ret, delay;
+
+    for(;;) {
+        /* take over new connections and wake up the ones waiting for
+           a feed that got new data or ended */
+        LOCK_SERVER();
+        LOCK_WORKER(w);
+        while ((c = w->new_ctx)) {
+            w->new_ctx   = c->next;
+            c->next      = w->first_ctx;
+            w->first_ctx = c;
+        }
+        UNLOCK_WORKER(w);
+        for (c = w->first_ctx; c != NULL; c = c->next) {
+            FFStream *feed = c->stream->feed;
+            if (c->state != HTTPSTATE_WAIT_FEED)
+                continue;
+            if (feed->feed_end_gen != c->feed_end_gen)
+                c->state = HTTPSTATE_SEND_DATA_TRAILER;
+            else if (feed->feed_data_gen != c->feed_data_gen)
+                c->state = HTTPSTATE_SEND_DATA;
+        }
+        UNLOCK_SERVER();
+
+        poll_entry = w->poll_table;
+        poll_entry->fd = w->wake_fds[0];
+        poll_entry->events = POLLIN;
+        poll_entry++;
+
+        delay = 1000;
+        for (c = w->first_ctx; c != NULL; c = c->next)
+            poll_entry = add_poll_entry(c, poll_entry, &delay);
+
+        do {
+            ret = poll(w->poll_table, poll_entry - w->poll_table, delay);
+            if (ret < 0 && ff_neterrno() != AVERROR(EAGAIN) &&
+                ff_neterrno() != AVERROR(EINTR)) {
+                http_log("poll failed in worker thread: %s\n", strerror(errno));
+                return NULL;
+            }
+        } while (ret < 0);
+
+        w->cur_time = av_gettime() / 1000;
+
+        if (w->poll_table[0].revents & POLLIN)
+            while (read(w->wake_fds[0], buf, sizeof(buf)) > 0)
+                ;
+
+        for(c = w->first_ctx; c != NULL; c = c_next) {
+            c_next = c->next;
+            if (handle_connection(c) < 0) {
+                log_connection(c);
+                close_connection(c);
+            }
+        }
+    }
+    return NULL;
+}
+#endif
+
+static int start_workers(void)
+{
+#if HAVE_PTHREADS
+    int i, ret;
+
+    if (!nb_workers)
+        return 0;
+
+    if (!(workers = av_mallocz(nb_workers * sizeof(*workers))))
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < nb_workers; i++) {
+        HTTPWorker *w = &workers[i];
+
+        w->cur_time   = av_gettime() / 1000;
+        w->poll_table = av_mallocz((nb_max_http_connections + 1) * sizeof(*w->poll_table));
+        if (!w->poll_table || pipe(w->wake_fds) < 0) {
+            http_log("Could not allocate worker thread resources\n");
+            return -1;
+        }
+        fcntl(w->wake_fds[0], F_SETFL, O_NONBLOCK);
+        fcntl(w->wake_fds[1], F_SETFL, O_NONBLOCK);
+        pthread_mutex_init(&w->lock, NULL);
+
+        if ((ret = pthread_create(&w->thread, NULL, http_worker, w))) {
+            http_log("Could not create worker thread: %s\n", strerror(ret));
+            return -1;
+        }
+    }
+    http_log("Serving stream connections with %d worker threads.\n", nb_workers);
+#endif
+    return 0;
+}
+
 static int http_server(void)
 {
     int server_fd = 0, rtsp_server_fd = 0;
-    int ret, delay, delay1;
+    int ret, delay;
     struct pollfd *poll_table, *poll_entry;
     HTTPContext *c, *c_next;
 
@@ -665,6 +947,9 @@ static int http_server(void)
 
     start_multicast();
 
+    if (start_workers() < 0)
+        return -1;
+
     for(;;) {
         poll_entry = poll_table;
         if (server_fd) {
@@ -679,54 +964,9 @@ static int http_server(void)
         }
 
         /* wait for events on each HTTP handle */
-        c = first_http_ctx;
         delay = 1000;
-        while (c != NULL) {
-            int fd;
-            fd = c->fd;
-            switch(c->state) {
-            case HTTPSTATE_SEND_HEADER:
-            case RTSPSTATE_SEND_REPLY:
-            case RTSPSTATE_SEND_PACKET:
-                c->poll_entry = poll_entry;
-                poll_entry->fd = fd;
-                poll_entry->events = POLLOUT;
-                poll_entry++;
-                break;
-            case HTTPSTATE_SEND_DATA_HEADER:
-            case HTTPSTATE_SEND_DATA:
-            case HTTPSTATE_SEND_DATA_TRAILER:
-                if (!c->is_packetized) {
-                    /* for TCP, we output as much as we can (may need to put a limit) */
-                    c->poll_entry = poll_entry;
-                    poll_entry->fd = fd;
-                    poll_entry->events = POLLOUT;
-                    poll_entry++;
-                } else {
-                    /* when ffserver is doing the timing, we work by
-                       looking at which packet need to be sent every
-                       10 ms */
-                    delay1 = 10; /* one tick wait XXX: 10 ms assumed */
-                    if (delay1 < delay)
-                        delay = delay1;
-                }
-                break;
-            case HTTPSTATE_WAIT_REQUEST:
-            case HTTPSTATE_RECEIVE_DATA:
-            case HTTPSTATE_WAIT_FEED:
-            case RTSPSTATE_WAIT_REQUEST:
-                /* need to catch errors */
-                c->poll_entry = poll_entry;
-                poll_entry->fd = fd;
-                poll_entry->events = POLLIN;/* Maybe this will work */
-                poll_entry++;
-                break;
-            default:
-                c->poll_entry = NULL;
-                break;
-            }
-            c = c->next;
-        }
+        for (c = first_http_ctx; c != NULL; c = c->next)
+            poll_entry = add_poll_entry(c, poll_entry, &delay);
 
         /* wait for an event on one connection. We poll at least every
            second to handle timeouts */
@@ -751,6 +991,8 @@ static int http_server(void)
                 /* close and free the connection */
                 log_connection(c);
                 close_connection(c);
+            } else if (c->to_worker) {
+                hand_over_connection(c);
             }
         }
 
@@ -784,7 +1026,7 @@ static void start_wait_request(HTTPContext *c, int is_rtsp)
     }
 }
 
-static void http_send_too_busy_reply(int fd)
+static void http_send_too_busy_reply(int fd, unsigned nb)
 {
     char buffer[400];
     int len = snprintf(buffer, sizeof(buffer),
@@ -795,7 +1037,7 @@ static void http_send_too_busy_reply(int fd)
                        "<p>The server is too busy to serve your request at this time.</p>\r\n"
                        "<p>The number of current connections is %u, and this exceeds the limit of %u.</p>\r\n"
                        "</body></html>\r\n",
-                       nb_connections, nb_max_connections);
+                       nb, nb_max_connections);
     av_assert0(len < sizeof(buffer));
     send(fd, buffer, len, 0);
 }
@@ -806,6 +1048,7 @@ static void new_connection(int server_fd, int is_rtsp)
     struct sockaddr_in from_addr;
     socklen_t len;
     int fd;
+    unsigned nb;
     HTTPContext *c = NULL;
 
     len = sizeof(from_addr);
@@ -817,8 +1060,11 @@ static void new_connection(int server_fd, int is_rtsp)
     }
     ff_socket_nonblock(fd, 1);
 
-    if (nb_connections >= nb_max_connections) {
-        http_send_too_busy_reply(fd);
+    LOCK_SERVER();
+    nb = nb_connections;
+    UNLOCK_SERVER();
+    if (nb >= nb_max_connections) {
+        http_send_too_busy_reply(fd, nb);
         goto fail;
     }
 
@@ -837,7 +1083,9 @@ static void new_connection(int server_fd, int is_rtsp)
 
     c->next = first_http_ctx;
     first_http_ctx = c;
+    LOCK_SERVER();
     nb_connections++;
+    UNLOCK_SERVER();
 
     start_wait_request(c, is_rtsp);
 
@@ -857,10 +1105,11 @@ static void close_connection(HTTPContext *c)
     int i, nb_streams;
     AVFormatContext *ctx;
     URLContext *h;
-    AVStream *st;
 
     /* remove connection from list */
-    cp = &first_http_ctx;
+    if (c->worker)
+        LOCK_WORKER(c->worker);
+    cp = c->worker ? &c->worker->first_ctx : &first_http_ctx;
     while ((*cp) != NULL) {
         c1 = *cp;
         if (c1 == c)
@@ -868,25 +1117,24 @@ static void close_connection(HTTPContext *c)
         else
             cp = &c1->next;
     }
+    if (c->worker)
+        UNLOCK_WORKER(c->worker);
 
     /* remove references, if any (XXX: do it faster) */
-    for(c1 = first_http_ctx; c1 != NULL; c1 = c1->next) {
-        if (c1->rtsp_c == c)
-            c1->rtsp_c = NULL;
+    if (!c->worker) {
+        for(c1 = first_http_ctx; c1 != NULL; c1 = c1->next) {
+            if (c1->rtsp_c == c)
+                c1->rtsp_c = NULL;
+        }
     }
 
     /* remove connection associated resources */
     if (c->fd >= 0)
         closesocket(c->fd);
-    if (c->fmt_in) {
-        /* close each frame parser */
-        for(i=0;i<c->fmt_in->nb_streams;i++) {
-            st = c->fmt_in->streams[i];
-            if (st->codec->codec)
-                avcodec_close(st->codec);
-        }
-        avformat_close_input(&c->fmt_in);
-    }
+    if (c->fmt_in)
+        close_input_stream(&c->fmt_in);
+    av_buffer_unref(&c->chunk);
+    release_shared_mux(c);
 
     /* free RTP output streams if any */
     nb_streams = 0;
@@ -919,13 +1167,16 @@ static void close_connection(HTTPContext *c)
         }
     }
 
-    for(i=0; i<ctx->nb_streams; i++)
-        av_free(ctx->streams[i]);
-    av_freep(&ctx->streams);
+    free_output_streams(ctx);
     av_freep(&ctx->priv_data);
 
+    LOCK_SERVER();
     if (c->stream && !c->post && c->stream->stream_type == STREAM_TYPE_LIVE)
         current_bandwidth -= c->stream->bandwidth;
+    nb_connections--;
+    if (c->worker)
+        c->worker->nb_conns--;
+    UNLOCK_SERVER();
 
     /* signal that there is no feed if we are the feeder socket */
     if (c->state == HTTPSTATE_RECEIVE_DATA && c->stream) {
@@ -937,7 +1188,6 @@ static void close_connection(HTTPContext *c)
     av_freep(&c->packet_buffer);
     av_free(c->buffer);
     av_free(c);
-    nb_connections--;
 }
 
 static int handle_connection(HTTPContext *c)
@@ -1005,7 +1255,7 @@ static int handle_connection(HTTPContext *c)
         } else {
             c->buffer_ptr += len;
             if (c->stream)
-                c->stream->bytes_served += len;
+                add_bytes_served(c->stream, len);
             c->data_count += len;
             if (c->buffer_ptr >= c->buffer_end) {
                 av_freep(&c->pb_buffer);
@@ -1500,9 +1750,10 @@ static int http_parse_request(HTTPContext *c)
     char msg[1024];
     const char *mime_type;
     FFStream *stream;
-    int i;
+    int i, ret;
     char ratebuf[32];
     const char *useragent = 0;
+    uint64_t bandwidth;
 
     p = c->buffer;
     get_word(cmd, sizeof(cmd), &p);
@@ -1619,8 +1870,11 @@ static int http_parse_request(HTTPContext *c)
         }
     }
 
+    LOCK_SERVER();
     if (c->post == 0 && stream->stream_type == STREAM_TYPE_LIVE)
         current_bandwidth += stream->bandwidth;
+    bandwidth = current_bandwidth;
+    UNLOCK_SERVER();
 
     /* If already streaming this feed, do not let start another feeder. */
     if (stream->feed_opened) {
@@ -1629,7 +1883,7 @@ static int http_parse_request(HTTPContext *c)
         goto send_error;
     }
 
-    if (c->post == 0 && max_bandwidth < current_bandwidth) {
+    if (c->post == 0 && max_bandwidth < bandwidth) {
         c->http_error = 503;
         q = c->buffer;
         snprintf(q, c->buffer_size,
@@ -1640,7 +1894,7 @@ static int http_parse_request(HTTPContext *c)
                       "<p>The server is too busy to serve your request at this time.</p>\r\n"
                       "<p>The bandwidth being served (including your stream) is %"PRIu64"kbit/sec, "
                       "and this exceeds the limit of %"PRIu64"kbit/sec.</p>\r\n"
-                      "</body></html>\r\n", current_bandwidth, max_bandwidth);
+                      "</body></html>\r\n", bandwidth, max_bandwidth);
         q += strlen(q);
         /* prepare output buffer */
         c->buffer_ptr = c->buffer;
@@ -1852,8 +2106,13 @@ static int http_parse_request(HTTPContext *c)
     if (c->stream->stream_type == STREAM_TYPE_STATUS)
         goto send_status;
 
-    /* open input stream */
-    if (open_input_stream(c, info) < 0) {
+    /* open input stream, connections without a specific start position
+       share the muxed output of the stream */
+    if (can_share_mux(c->stream) && !info[0])
+        ret = join_shared_mux(c);
+    else
+        ret = open_input_stream(c, info);
+    if (ret < 0) {
         snprintf(msg, sizeof(msg), "Input stream corresponding to '%s' not found", url);
         goto send_error;
     }
@@ -1883,6 +2142,9 @@ static int http_parse_request(HTTPContext *c)
     c->buffer_ptr = c->buffer;
     c->buffer_end = q;
     c->state = HTTPSTATE_SEND_HEADER;
+    /* ASF clients may switch rates through a later request, which is
+     * looked up in the main loop, so keep them there */
+    c->to_worker = nb_workers > 0 && !c->wmp_client_id;
     return 0;
  send_error:
     c->http_error = 404;
@@ -1919,13 +2181,44 @@ static void fmt_bytecount(AVIOContext *pb, int64_t count)
     avio_printf(pb, "%"PRId64"%c", count, *s);
 }
 
+/* print a row of the connection table of the status page */
+static void print_connection_status(AVIOContext *pb, HTTPContext *c1, int i)
+{
+    int bitrate = 0;
+    int j;
+
+    if (c1->stream) {
+        for (j = 0; j < c1->stream->nb_streams; j++) {
+            if (!c1->stream->feed)
+                bitrate += c1->stream->streams[j]->codec->bit_rate;
+            else if (c1->feed_streams[j] >= 0)
+                bitrate += c1->stream->feed->streams[c1->feed_streams[j]]->codec->bit_rate;
+        }
+    }
+
+    avio_printf(pb, "<tr><td><b>%d</b><td>%s%s<td>%s<td>%s<td>%s<td align=right>",
+                i,
+                c1->stream ? c1->stream->filename : "",
+                c1->state == HTTPSTATE_RECEIVE_DATA ? "(input)" : "",
+                inet_ntoa(c1->from_addr.sin_addr),
+                c1->protocol,
+                http_state[c1->state]);
+    fmt_bytecount(pb, bitrate);
+    avio_printf(pb, "<td align=right>");
+    fmt_bytecount(pb, compute_datarate(&c1->datarate, c1->data_count) * 8);
+    avio_printf(pb, "<td align=right>");
+    fmt_bytecount(pb, c1->data_count);
+    avio_printf(pb, "\n");
+}
+
 static void compute_status(HTTPContext *c)
 {
     HTTPContext *c1;
     FFStream *stream;
     char *p;
     time_t ti;
-    int i, len;
+    int i, j, len;
+    int64_t bytes_served;
     AVIOContext *pb;
 
     if (avio_open_dyn_buf(&pb) < 0) {
@@ -1980,7 +2273,10 @@ static void compute_status(HTTPContext *c)
                          sfilename, stream->filename);
             avio_printf(pb, "<td align=right> %d <td align=right> ",
                         stream->conns_served);
-            fmt_bytecount(pb, stream->bytes_served);
+            LOCK_SERVER();
+            bytes_served = stream->bytes_served;
+            UNLOCK_SERVER();
+            fmt_bytecount(pb, bytes_served);
             switch(stream->stream_type) {
             case STREAM_TYPE_LIVE: {
                     int audio_bit_rate = 0;
@@ -2107,46 +2403,28 @@ static void compute_status(HTTPContext *c)
     /* connection status */
     avio_printf(pb, "<h2>Connection Status</h2>\n");
 
+    LOCK_SERVER();
     avio_printf(pb, "Number of connections: %d / %d<br>\n",
                  nb_connections, nb_max_connections);
 
     avio_printf(pb, "Bandwidth in use: %"PRIu64"k / %"PRIu64"k<br>\n",
                  current_bandwidth, max_bandwidth);
 
+    for (i = 0; i < nb_workers; i++)
+        avio_printf(pb, "Worker %d: %d connections<br>\n", i, workers[i].nb_conns);
+    UNLOCK_SERVER();
+
     avio_printf(pb, "<table>\n");
     avio_printf(pb, "<tr><th>#<th>File<th>IP<th>Proto<th>State<th>Target bits/sec<th>Actual bits/sec<th>Bytes transferred\n");
-    c1 = first_http_ctx;
     i = 0;
-    while (c1 != NULL) {
-        int bitrate;
-        int j;
-
-        bitrate = 0;
-        if (c1->stream) {
-            for (j = 0; j < c1->stream->nb_streams; j++) {
-                if (!c1->stream->feed)
-                    bitrate += c1->stream->streams[j]->codec->bit_rate;
-                else if (c1->feed_streams[j] >= 0)
-                    bitrate += c1->stream->feed->streams[c1->feed_streams[j]]->codec->bit_rate;
-            }
-        }
-
-        i++;
-        p = inet_ntoa(c1->from_addr.sin_addr);
-        avio_printf(pb, "<tr><td><b>%d</b><td>%s%s<td>%s<td>%s<td>%s<td align=right>",
-                    i,
-                    c1->stream ? c1->stream->filename : "",
-                    c1->state == HTTPSTATE_RECEIVE_DATA ? "(input)" : "",
-                    p,
-                    c1->protocol,
-                    http_state[c1->state]);
-        fmt_bytecount(pb, bitrate);
-        avio_printf(pb, "<td align=right>");
-        fmt_bytecount(pb, compute_datarate(&c1->datarate, c1->data_count) * 8);
-        avio_printf(pb, "<td align=right>");
-        fmt_bytecount(pb, c1->data_count);
-        avio_printf(pb, "\n");
-        c1 = c1->next;
+    for (c1 = first_http_ctx; c1 != NULL; c1 = c1->next)
+        print_connection_status(pb, c1, ++i);
+    /* the workers only change their lists under their lock */
+    for (j = 0; j < nb_workers; j++) {
+        LOCK_WORKER(&workers[j]);
+        for (c1 = workers[j].first_ctx; c1 != NULL; c1 = c1->next)
+            print_connection_status(pb, c1, ++i);
+        UNLOCK_WORKER(&workers[j]);
     }
     avio_printf(pb, "</table>\n");
 
@@ -2196,7 +2474,10 @@ static int open_input_stream(HTTPContext *c, const char *info)
         return -1;
 
     /* open stream */
-    if ((ret = avformat_open_input(&s, input_filename, c->stream->ifmt, &c->stream->in_opts)) < 0) {
+    LOCK_SERVER();
+    ret = avformat_open_input(&s, input_filename, c->stream->ifmt, &c->stream->in_opts);
+    UNLOCK_SERVER();
+    if (ret < 0) {
         http_log("could not open %s: %d\n", input_filename, ret);
         return -1;
     }
@@ -2225,7 +2506,7 @@ static int open_input_stream(HTTPContext *c, const char *info)
     if (c->fmt_in->iformat->read_seek)
         av_seek_frame(c->fmt_in, -1, stream_pos, 0);
     /* set the start time (needed for maxtime and RTP packet timing) */
-    c->start_time = cur_time;
+    c->start_time = conn_time(c);
     c->first_pts = AV_NOPTS_VALUE;
     return 0;
 }
@@ -2254,80 +2535,491 @@ static int64_t get_packet_send_clock(HTTPContext *c)
 }
 
 
-static int http_prepare_data(HTTPContext *c)
+/* free the streams set up by open_output_format() */
+static void free_output_streams(AVFormatContext *ctx)
 {
-    int i, len, ret;
-    AVFormatContext *ctx;
+    int i;
 
-    av_freep(&c->pb_buffer);
-    switch(c->state) {
-    case HTTPSTATE_SEND_DATA_HEADER:
-        memset(&c->fmt_ctx, 0, sizeof(c->fmt_ctx));
-        av_dict_set(&c->fmt_ctx.metadata, "author"   , c->stream->author   , 0);
-        av_dict_set(&c->fmt_ctx.metadata, "comment"  , c->stream->comment  , 0);
-        av_dict_set(&c->fmt_ctx.metadata, "copyright", c->stream->copyright, 0);
-        av_dict_set(&c->fmt_ctx.metadata, "title"    , c->stream->title    , 0);
-
-        c->fmt_ctx.streams = av_mallocz(sizeof(AVStream *) * c->stream->nb_streams);
-
-        for(i=0;i<c->stream->nb_streams;i++) {
-            AVStream *src;
-            c->fmt_ctx.streams[i] = av_mallocz(sizeof(AVStream));
-            /* if file or feed, then just take streams from FFStream struct */
-            if (!c->stream->feed ||
-                c->stream->feed == c->stream)
-                src = c->stream->streams[i];
-            else
-                src = c->stream->feed->streams[c->stream->feed_streams[i]];
-
-            *(c->fmt_ctx.streams[i]) = *src;
-            c->fmt_ctx.streams[i]->priv_data = 0;
-            c->fmt_ctx.streams[i]->codec->frame_number = 0; /* XXX: should be done in
-                                           AVStream, not in codec */
+    for (i = 0; i < ctx->nb_streams; i++) {
+        AVCodecContext *codec = ctx->streams[i]->codec;
+        av_freep(&codec->rc_eq);
+        av_freep(&codec->extradata);
+        av_freep(&codec->intra_matrix);
+        av_freep(&codec->inter_matrix);
+        av_freep(&codec->rc_override);
+        av_freep(&codec->subtitle_header);
+        av_free(codec);
+        av_free(ctx->streams[i]);
+    }
+    av_freep(&ctx->streams);
+}
+
+/* set up the output format of a stream and return the header data,
+   must be called without server_lock */
+static int open_output_format(FFStream *stream, AVFormatContext *ctx,
+                              uint8_t **header)
+{
+    int i;
+
+    memset(ctx, 0, sizeof(*ctx));
+    av_dict_set(&ctx->metadata, "author"   , stream->author   , 0);
+    av_dict_set(&ctx->metadata, "comment"  , stream->comment  , 0);
+    av_dict_set(&ctx->metadata, "copyright", stream->copyright, 0);
+    av_dict_set(&ctx->metadata, "title"    , stream->title    , 0);
+
+    ctx->streams = av_mallocz(sizeof(AVStream *) * stream->nb_streams);
+
+    /* the feed streams are updated when a feeder connects, so they are
+       copied under the lock, but the header is written without it */
+    LOCK_SERVER();
+    for(i=0;i<stream->nb_streams;i++) {
+        AVStream *src;
+        AVCodecContext *codec;
+        ctx->streams[i] = av_mallocz(sizeof(AVStream));
+        /* if file or feed, then just take streams from FFStream struct */
+        if (!stream->feed ||
+            stream->feed == stream)
+            src = stream->streams[i];
+        else
+            src = stream->feed->streams[stream->feed_streams[i]];
+
+        *(ctx->streams[i]) = *src;
+        ctx->streams[i]->priv_data = 0;
+
+        /* the feed codec context is replaced when a feeder connects, which
+           must not happen under a muxer running in a worker thread */
+        codec = avcodec_alloc_context3(NULL);
+        if (!codec || avcodec_copy_context(codec, src->codec) < 0) {
+            av_free(codec);
+            av_freep(&ctx->streams[i]);
+            break;
         }
-        /* set output format parameters */
-        c->fmt_ctx.oformat = c->stream->fmt;
-        c->fmt_ctx.nb_streams = c->stream->nb_streams;
+        ctx->streams[i]->codec = codec;
+        ctx->streams[i]->codec->frame_number = 0; /* XXX: should be done in
+                                       AVStream, not in codec */
+    }
+    UNLOCK_SERVER();
+    ctx->nb_streams = i;
+    if (i < stream->nb_streams)
+        return -1;
 
-        c->got_key_frame = 0;
+    /* set output format parameters */
+    ctx->oformat = stream->fmt;
 
-        /* prepare header and save header data in a stream */
-        if (avio_open_dyn_buf(&c->fmt_ctx.pb) < 0) {
-            /* XXX: potential leak */
+    /* prepare header and save header data in a stream */
+    if (avio_open_dyn_buf(&ctx->pb) < 0) {
+        /* XXX: potential leak */
+        return -1;
+    }
+    ctx->pb->seekable = 0;
+
+    /*
+     * HACK to avoid mpeg ps muxer to spit many underflow errors
+     * Default value from FFmpeg
+     * Try to set it use configuration option
+     */
+    ctx->max_delay = (int)(0.7*AV_TIME_BASE);
+
+    if (avformat_write_header(ctx, NULL) < 0) {
+        http_log("Error writing output header\n");
+        return -1;
+    }
+    av_dict_free(&ctx->metadata);
+
+    return avio_close_dyn_buf(ctx->pb, header);
+}
+
+/* write the output format header of a stream connection */
+static int prepare_header(HTTPContext *c)
+{
+    int len;
+
+    c->got_key_frame = 0;
+
+    len = open_output_format(c->stream, &c->fmt_ctx, &c->pb_buffer);
+    if (len < 0)
+        return -1;
+    c->buffer_ptr = c->pb_buffer;
+    c->buffer_end = c->pb_buffer + len;
+
+    c->state = HTTPSTATE_SEND_DATA;
+    c->last_packet_sent = 0;
+    return 0;
+}
+
+/* true if the connections to the stream can share the output of one
+   muxer, i.e. the data muxed after the header can be joined at any packet */
+static int can_share_mux(FFStream *stream)
+{
+    static const char * const formats[] = {
+        "mpeg", "mpegts", "mpjpeg", "mp2", "mp3", "adts", NULL
+    };
+    int i;
+
+    if (!stream->feed || stream->feed == stream)
+        return 0;
+    for (i = 0; formats[i]; i++)
+        if (!strcmp(stream->fmt->name, formats[i]))
+            return 1;
+    return 0;
+}
+
+static void close_input_stream(AVFormatContext **ps)
+{
+    AVFormatContext *s = *ps;
+    int i;
+
+    /* close each frame parser */
+    for(i=0;i<s->nb_streams;i++) {
+        AVStream *st = s->streams[i];
+        if (st->codec->codec)
+            avcodec_close(st->codec);
+    }
+    avformat_close_input(ps);
+}
+
+static void close_shared_mux(SharedMux *mux)
+{
+    AVFormatContext *ctx = &mux->fmt_ctx;
+    uint8_t *buf;
+    int i;
+
+    if (mux->fmt_in)
+        close_input_stream(&mux->fmt_in);
+    /* nobody gets the trailer, but it frees the muxer state */
+    if (mux->header && !mux->finished && avio_open_dyn_buf(&ctx->pb) >= 0) {
+        av_write_trailer(ctx);
+        avio_close_dyn_buf(ctx->pb, &buf);
+        av_free(buf);
+    }
+    free_output_streams(ctx);
+    av_freep(&ctx->priv_data);
+    av_dict_free(&ctx->metadata);
+
+    av_buffer_unref(&mux->header);
+    av_buffer_unref(&mux->trailer);
+    for (i = 0; i < SHARED_MUX_CHUNKS; i++)
+        av_buffer_unref(&mux->chunks[i]);
+#if HAVE_PTHREADS
+    pthread_mutex_destroy(&mux->lock);
+#endif
+    av_free(mux);
+}
+
+/* attach a connection to the shared muxer of its stream, a new muxer is
+   opened if there is none or if it was opened for an earlier feeder */
+static int join_shared_mux(HTTPContext *c)
+{
+    FFStream *stream = c->stream;
+    SharedMux *mux;
+    uint8_t *header;
+    int len;
+
+    LOCK_SERVER();
+    mux = stream->mux;
+    if (mux && mux->feed_end_gen == stream->feed->feed_end_gen)
+        mux->nb_users++;
+    else
+        mux = NULL;
+    UNLOCK_SERVER();
+
+    if (!mux) {
+        if (!(mux = av_mallocz(sizeof(*mux))))
+            return AVERROR(ENOMEM);
+#if HAVE_PTHREADS
+        pthread_mutex_init(&mux->lock, NULL);
+#endif
+
+        /* the muxer reads the feed from where the connection would have */
+        if (open_input_stream(c, "") < 0) {
+            av_free(mux);
+            return -1;
+        }
+        mux->fmt_in = c->fmt_in;
+        c->fmt_in = NULL;
+
+        len = open_output_format(stream, &mux->fmt_ctx, &header);
+        if (len >= 0) {
+            mux->header = av_buffer_create(header, len, av_buffer_default_free,
+                                           NULL, 0);
+            if (!mux->header)
+                av_free(header);
+        }
+        if (!mux->header) {
+            close_shared_mux(mux);
             return -1;
         }
-        c->fmt_ctx.pb->seekable = 0;
 
-        /*
-         * HACK to avoid mpeg ps muxer to spit many underflow errors
-         * Default value from FFmpeg
-         * Try to set it use configuration option
-         */
-        c->fmt_ctx.max_delay = (int)(0.7*AV_TIME_BASE);
+        /* a muxer left from an earlier feeder is freed by its last user */
+        LOCK_SERVER();
+        mux->feed_end_gen = stream->feed->feed_end_gen;
+        mux->nb_users = 1;
+        stream->mux = mux;
+        UNLOCK_SERVER();
+    }
 
-        if (avformat_write_header(&c->fmt_ctx, NULL) < 0) {
-            http_log("Error writing output header\n");
-            return -1;
+    c->mux = mux;
+    c->start_time = conn_time(c);
+    c->first_pts = AV_NOPTS_VALUE;
+    return 0;
+}
+
+static void release_shared_mux(HTTPContext *c)
+{
+    SharedMux *mux = c->mux;
+    int last;
+
+    if (!mux)
+        return;
+
+    LOCK_SERVER();
+    c->mux = NULL;
+    last = !--mux->nb_users;
+    if (last && c->stream->mux == mux)
+        c->stream->mux = NULL;
+    UNLOCK_SERVER();
+
+    if (last)
+        close_shared_mux(mux);
+}
+
+/* move a connection to the oldest sync point still buffered by its muxer */
+static void sync_shared_mux(HTTPContext *c)
+{
+    SharedMux *mux = c->mux;
+    int64_t oldest = FFMAX(mux->nb_chunks - SHARED_MUX_CHUNKS, 0);
+    int64_t pos;
+
+    for (pos = oldest; pos < mux->nb_chunks; pos++)
+        if (mux->key[pos % SHARED_MUX_CHUNKS])
+            break;
+
+    if (pos < mux->nb_chunks) {
+        c->mux_pos = pos;
+        c->got_key_frame = 1;
+    } else {
+        c->mux_pos = oldest;
+        c->got_key_frame = !c->stream->send_on_key;
+    }
+}
+
+/* mux the next packet of the feed into the ring, return 1 at the end
+   of the feed data; write_index and feed_size are a snapshot of the feed
+   state, as the muxer is not read under server_lock */
+static int shared_mux_read(FFStream *stream, SharedMux *mux,
+                           int64_t write_index, int64_t feed_size)
+{
+    AVFormatContext *ctx = &mux->fmt_ctx;
+    AVBufferRef *buf;
+    AVPacket pkt;
+    uint8_t *data;
+    int i, ret, len, key = 0;
+
+    ffm_set_write_index(mux->fmt_in, write_index, feed_size);
+
+    for (;;) {
+        AVStream *ist, *ost;
+
+        if (av_read_frame(mux->fmt_in, &pkt) < 0)
+            return 1;
+
+        for (i = 0; i < stream->nb_streams; i++)
+            if (stream->feed_streams[i] == pkt.stream_index)
+                break;
+        if (i == stream->nb_streams) {
+            av_free_packet(&pkt);
+            continue;
         }
-        av_dict_free(&c->fmt_ctx.metadata);
+        ist = mux->fmt_in->streams[pkt.stream_index];
+        ost = ctx->streams[i];
+
+        /* a key frame can be held back by the muxer, so remember it until
+           some data is output */
+        if (pkt.flags & AV_PKT_FLAG_KEY &&
+            (ist->codec->codec_type == AVMEDIA_TYPE_VIDEO ||
+             stream->nb_streams == 1))
+            key = 1;
+
+        pkt.stream_index = i;
+        if (pkt.dts != AV_NOPTS_VALUE)
+            pkt.dts = av_rescale_q(pkt.dts, ist->time_base, ost->time_base);
+        if (pkt.pts != AV_NOPTS_VALUE)
+            pkt.pts = av_rescale_q(pkt.pts, ist->time_base, ost->time_base);
+        pkt.duration = av_rescale_q(pkt.duration, ist->time_base, ost->time_base);
+
+        if ((ret = avio_open_dyn_buf(&ctx->pb)) < 0) {
+            av_free_packet(&pkt);
+            return ret;
+        }
+        ctx->pb->seekable = 0;
+        ret = av_write_frame(ctx, &pkt);
+        len = avio_close_dyn_buf(ctx->pb, &data);
+        av_free_packet(&pkt);
+        ost->codec->frame_number++;
 
-        len = avio_close_dyn_buf(c->fmt_ctx.pb, &c->pb_buffer);
-        c->buffer_ptr = c->pb_buffer;
-        c->buffer_end = c->pb_buffer + len;
+        if (ret < 0) {
+            http_log("Error writing frame to output\n");
+            av_free(data);
+            return ret;
+        }
+        if (len > 0)
+            break;
+        av_free(data);
+    }
+
+    buf = av_buffer_create(data, len, av_buffer_default_free, NULL, 0);
+    if (!buf) {
+        av_free(data);
+        return AVERROR(ENOMEM);
+    }
+    i = mux->nb_chunks % SHARED_MUX_CHUNKS;
+    av_buffer_unref(&mux->chunks[i]);
+    mux->chunks[i] = buf;
+    mux->key[i]    = key;
+    mux->nb_chunks++;
+    return 0;
+}
+
+/* flush the packets held back by the muxer once the feeder is gone */
+static int shared_mux_write_trailer(SharedMux *mux)
+{
+    AVFormatContext *ctx = &mux->fmt_ctx;
+    uint8_t *data;
+    int ret, len;
+
+    if ((ret = avio_open_dyn_buf(&ctx->pb)) < 0)
+        return ret;
+    ctx->pb->seekable = 0;
+    av_write_trailer(ctx);
+    len = avio_close_dyn_buf(ctx->pb, &data);
+    mux->finished = 1;
+
+    mux->trailer = av_buffer_create(data, len, av_buffer_default_free, NULL, 0);
+    if (!mux->trailer) {
+        av_free(data);
+        return AVERROR(ENOMEM);
+    }
+    return 0;
+}
+
+/* send the header of the shared muxer */
+static int prepare_shared_header(HTTPContext *c)
+{
+    LOCK_MUX(c->mux);
+    sync_shared_mux(c);
+    UNLOCK_MUX(c->mux);
+    if (!(c->chunk = av_buffer_ref(c->mux->header)))
+        return -1;
+    c->buffer_ptr = c->chunk->data;
+    c->buffer_end = c->chunk->data + c->chunk->size;
+
+    c->state = HTTPSTATE_SEND_DATA;
+    c->last_packet_sent = 0;
+    return 0;
+}
+
+/* take the next chunk to send from the shared muxer, muxing it if this
+   connection is the first one to need it */
+static int http_prepare_shared_data(HTTPContext *c)
+{
+    SharedMux *mux = c->mux;
+    FFStream *feed = c->stream->feed;
+    int64_t write_index, feed_size;
+    unsigned feed_end_gen;
+    int ret = 0;
 
-        c->state = HTTPSTATE_SEND_DATA;
-        c->last_packet_sent = 0;
+    if (c->last_packet_sent)
+        return -1;
+    if (c->stream->max_time &&
+        c->stream->max_time + c->start_time - conn_time(c) < 0)
+        /* We have timed out */
+        return -1;
+
+    /* the feed state is read at once, so that the connection is woken up
+       again if the feeder writes more data while the muxer runs */
+    LOCK_SERVER();
+    c->feed_data_gen = feed->feed_data_gen;
+    c->feed_end_gen  = feed_end_gen = feed->feed_end_gen;
+    write_index      = feed->feed_write_index;
+    feed_size        = feed->feed_size;
+    UNLOCK_SERVER();
+
+    /* only the connections of this muxer wait for each other */
+    LOCK_MUX(mux);
+    while (!c->chunk) {
+        int i;
+
+        /* the connection was too slow to keep up with the others */
+        if (c->mux_pos < mux->nb_chunks - SHARED_MUX_CHUNKS)
+            sync_shared_mux(c);
+
+        if (c->mux_pos == mux->nb_chunks) {
+            if (!mux->finished) {
+                ret = shared_mux_read(c->stream, mux, write_index, feed_size);
+                if (ret > 0 && mux->feed_end_gen != feed_end_gen)
+                    ret = shared_mux_write_trailer(mux);
+                if (ret)
+                    break;
+            }
+            if (mux->finished) {
+                c->last_packet_sent = 1;
+                if (!(c->chunk = av_buffer_ref(mux->trailer)))
+                    ret = AVERROR(ENOMEM);
+                break;
+            }
+        }
+
+        i = c->mux_pos++ % SHARED_MUX_CHUNKS;
+        if (mux->key[i])
+            c->got_key_frame = 1;
+        if (c->got_key_frame && !(c->chunk = av_buffer_ref(mux->chunks[i]))) {
+            ret = AVERROR(ENOMEM);
+            break;
+        }
+    }
+    UNLOCK_MUX(mux);
+
+    if (ret > 0) {
+        /* wait for the feeder to write more data */
+        c->state = HTTPSTATE_WAIT_FEED;
+        return 1; /* state changed */
+    } else if (ret < 0)
+        return -1;
+    c->buffer_ptr = c->chunk->data;
+    c->buffer_end = c->chunk->data + c->chunk->size;
+    return 0;
+}
+
+static int http_prepare_data(HTTPContext *c)
+{
+    int i, len, ret;
+    AVFormatContext *ctx;
+
+    av_freep(&c->pb_buffer);
+    av_buffer_unref(&c->chunk);
+    switch(c->state) {
+    case HTTPSTATE_SEND_DATA_HEADER:
+        ret = c->mux ? prepare_shared_header(c) : prepare_header(c);
+        if (ret < 0)
+            return -1;
         break;
     case HTTPSTATE_SEND_DATA:
+        if (c->mux)
+            return http_prepare_shared_data(c);
         /* find a new packet */
         /* read a packet from the input stream */
-        if (c->stream->feed)
+        if (c->stream->feed) {
+            LOCK_SERVER();
             ffm_set_write_index(c->fmt_in,
                                 c->stream->feed->feed_write_index,
                                 c->stream->feed->feed_size);
+            c->feed_data_gen = c->stream->feed->feed_data_gen;
+            c->feed_end_gen  = c->stream->feed->feed_end_gen;
+            UNLOCK_SERVER();
+        }
 
         if (c->stream->max_time &&
-            c->stream->max_time + c->start_time - cur_time < 0)
+            c->stream->max_time + c->start_time - conn_time(c) < 0)
             /* We have timed out */
             c->state = HTTPSTATE_SEND_DATA_TRAILER;
         else {
@@ -2360,7 +3052,7 @@ static int http_prepare_data(HTTPContext *c)
                 /* update first pts if needed */
                 if (c->first_pts == AV_NOPTS_VALUE) {
                     c->first_pts = av_rescale_q(pkt.dts, c->fmt_in->streams[pkt.stream_index]->time_base, AV_TIME_BASE_Q);
-                    c->start_time = cur_time;
+                    c->start_time = conn_time(c);
                 }
                 /* send it to the appropriate stream */
                 if (c->stream->feed) {
@@ -2448,7 +3140,10 @@ static int http_prepare_data(HTTPContext *c)
                     c->buffer_ptr = c->pb_buffer;
                     c->buffer_end = c->pb_buffer + len;
 
+                    /* the codec context is shared by the connections */
+                    LOCK_SERVER();
                     codec->frame_number++;
+                    UNLOCK_SERVER();
                     if (len == 0) {
                         av_free_packet(&pkt);
                         goto redo;
@@ -2460,6 +3155,9 @@ static int http_prepare_data(HTTPContext *c)
         break;
     default:
     case HTTPSTATE_SEND_DATA_TRAILER:
+        /* the remaining data of a shared muxer ends with its trailer */
+        if (c->mux)
+            return http_prepare_shared_data(c);
         /* last packet test ? */
         if (c->last_packet_sent || c->is_packetized)
             return -1;
@@ -2518,9 +3216,9 @@ static int http_send_data(HTTPContext *c)
                 }
 
                 c->data_count += len;
-                update_datarate(&c->datarate, c->data_count);
+                update_datarate(&c->datarate, c->data_count, conn_time(c));
                 if (c->stream)
-                    c->stream->bytes_served += len;
+                    add_bytes_served(c->stream, len);
 
                 if (c->rtp_protocol == RTSP_LOWER_TRANSPORT_TCP) {
                     /* RTP packets are sent inside the RTSP TCP connection */
@@ -2593,9 +3291,9 @@ static int http_send_data(HTTPContext *c)
                     c->buffer_ptr += len;
 
                 c->data_count += len;
-                update_datarate(&c->datarate, c->data_count);
+                update_datarate(&c->datarate, c->data_count, conn_time(c));
                 if (c->stream)
-                    c->stream->bytes_served += len;
+                    add_bytes_served(c->stream, len);
                 break;
             }
         }
@@ -2631,14 +3329,16 @@ static int http_start_receive_data(HTTPContext *c)
             return -1;
         }
     } else {
-        if ((c->stream->feed_write_index = ffm_read_write_index(fd)) < 0) {
+        if (ffm_read_write_index(fd) < 0) {
             http_log("Error reading write index from feed file: %s\n", strerror(errno));
             return -1;
         }
     }
 
+    LOCK_SERVER();
     c->stream->feed_write_index = FFMAX(ffm_read_write_index(fd), FFM_PACKET_SIZE);
     c->stream->feed_size = lseek(fd, 0, SEEK_END);
+    UNLOCK_SERVER();
     lseek(fd, 0, SEEK_SET);
 
     /* init buffer input */
@@ -2698,7 +3398,7 @@ static int http_receive_data(HTTPContext *c)
             c->chunk_size -= len;
             c->buffer_ptr += len;
             c->data_count += len;
-            update_datarate(&c->datarate, c->data_count);
+            update_datarate(&c->datarate, c->data_count, conn_time(c));
         }
     }
 
@@ -2722,6 +3422,7 @@ static int http_receive_data(HTTPContext *c)
                 goto fail;
             }
 
+            LOCK_SERVER();
             feed->feed_write_index += FFM_PACKET_SIZE;
             /* update file size */
             if (feed->feed_write_index > c->stream->feed_size)
@@ -2730,6 +3431,8 @@ static int http_receive_data(HTTPContext *c)
             /* handle wrap around if max file size reached */
             if (c->stream->feed_max_size && feed->feed_write_index >= c->stream->feed_max_size)
                 feed->feed_write_index = FFM_PACKET_SIZE;
+            feed->feed_data_gen++;
+            UNLOCK_SERVER();
 
             /* write index */
             if (ffm_write_write_index(c->feed_fd, feed->feed_write_index) < 0) {
@@ -2743,6 +3446,7 @@ static int http_receive_data(HTTPContext *c)
                     c1->stream->feed == c->stream->feed)
                     c1->state = HTTPSTATE_SEND_DATA;
             }
+            wake_workers();
         } else {
             /* We have a header in our hands that contains useful data */
             AVFormatContext *s = avformat_alloc_context();
@@ -2777,11 +3481,13 @@ static int http_receive_data(HTTPContext *c)
                 goto fail;
             }
 
+            LOCK_SERVER();
             for (i = 0; i < s->nb_streams; i++) {
                 AVStream *fst = feed->streams[i];
                 AVStream *st = s->streams[i];
                 avcodec_copy_context(fst->codec, st->codec);
             }
+            UNLOCK_SERVER();
 
             avformat_close_input(&s);
             av_free(pb);
@@ -2799,6 +3505,10 @@ static int http_receive_data(HTTPContext *c)
             c1->stream->feed == c->stream->feed)
             c1->state = HTTPSTATE_SEND_DATA_TRAILER;
     }
+    LOCK_SERVER();
+    c->stream->feed_end_gen++;
+    UNLOCK_SERVER();
+    wake_workers();
     return -1;
 }
 
@@ -3347,10 +4057,14 @@ static HTTPContext *rtp_new_connection(struct sockaddr_in *from_addr,
 {
     HTTPContext *c = NULL;
     const char *proto_str;
+    unsigned nb;
 
     /* XXX: should output a warning page when coming
        close to the connection limit */
-    if (nb_connections >= nb_max_connections)
+    LOCK_SERVER();
+    nb = nb_connections;
+    UNLOCK_SERVER();
+    if (nb >= nb_max_connections)
         goto fail;
 
     /* add a new connection */
@@ -3365,7 +4079,6 @@ static HTTPContext *rtp_new_connection(struct sockaddr_in *from_addr,
     c->buffer = av_malloc(c->buffer_size);
     if (!c->buffer)
         goto fail;
-    nb_connections++;
     c->stream = stream;
     av_strlcpy(c->session_id, session_id, sizeof(c->session_id));
     c->state = HTTPSTATE_READY;
@@ -3390,7 +4103,10 @@ static HTTPContext *rtp_new_connection(struct sockaddr_in *from_addr,
     av_strlcpy(c->protocol, "RTP/", sizeof(c->protocol));
     av_strlcat(c->protocol, proto_str, sizeof(c->protocol));
 
+    LOCK_SERVER();
+    nb_connections++;
     current_bandwidth += stream->bandwidth;
+    UNLOCK_SERVER();
 
     c->next = first_http_ctx;
     first_http_ctx = c;
@@ -4148,6 +4864,15 @@ static int parse_ffconfig(const char *filename)
             } else {
                 nb_max_connections = val;
             }
+        } else if (!av_strcasecmp(cmd, "Workers")) {
+            get_arg(arg, sizeof(arg), &p);
+            val = atoi(arg);
+            if (val < 0 || val > 256) {
+                ERROR("Invalid Workers: %s\n", arg);
+            } else if (val && !HAVE_PTHREADS) {
+                ERROR("Workers requires thread support\n");
+            } else
+                nb_workers = val;
         } else if (!av_strcasecmp(cmd, "MaxBandwidth")) {
             int64_t llval;
             get_arg(arg, sizeof(arg), &p);
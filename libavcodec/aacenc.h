@@ -81,6 +81,9 @@ typedef struct AACEncContext {
     struct {
         float *samples;
     } buffer;
+
+    struct AACEncContext *thread_ctx;            ///< per thread copies used by the quantizer search
+    int nb_thread_ctx;
 } AACEncContext;
 
 extern float ff_aac_pow34sf_tab[428];
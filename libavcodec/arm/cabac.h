@@ -0,0 +1,185 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVCODEC_ARM_CABAC_H
+#define AVCODEC_ARM_CABAC_H
+
+#include <stddef.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavcodec/cabac.h"
+
+#if HAVE_ARMV6_INLINE && CABAC_BITS == 16 && !HAVE_BIGENDIAN
+
+extern uint8_t ff_h264_cabac_tables[512 + 4*2*64 + 4*64 + 63];
+
+/**
+ * Decode one bin with low and range held in registers by the caller;
+ * only the bytestream pointer is read from and written to c on refill.
+ * Flag checks use the sign of the differences like the C code does.
+ */
+static av_always_inline int get_cabac_core_arm(CABACContext *c, int *low,
+                                               int *range, uint8_t *const state)
+{
+    int bit;
+    void *reg_b, *reg_c, *tmp;
+
+    __asm__ volatile(
+        "ldrb       %[bit]    , [%[state]]                  \n\t"
+        "add        %[r_b]    , %[tables] , %[lps_off]      \n\t"
+        "mov        %[tmp]    , %[range]                    \n\t"
+        "and        %[range]  , %[range]  , #0xC0           \n\t"
+        "add        %[r_b]    , %[r_b]    , %[bit]          \n\t"
+        "ldrb       %[range]  , [%[r_b], %[range], lsl #1]  \n\t"
+        "add        %[r_b]    , %[tables] , %[norm_off]     \n\t"
+        "sub        %[r_c]    , %[tmp]    , %[range]        \n\t"
+        "lsl        %[tmp]    , %[r_c]    , #17             \n\t"
+        "cmp        %[tmp]    , %[low]                      \n\t"
+        "itee       pl                                      \n\t"
+        "movpl      %[range]  , %[r_c]                      \n\t"
+        "mvnmi      %[bit]    , %[bit]                      \n\t"
+        "submi      %[low]    , %[low]    , %[tmp]          \n\t"
+        "add        %[r_c]    , %[tables] , %[mlps_off]     \n\t"
+        "ldrb       %[tmp]    , [%[r_b], %[range]]          \n\t"
+        "ldrb       %[r_c]    , [%[r_c], %[bit]]            \n\t"
+        "lsl        %[low]    , %[low]    , %[tmp]          \n\t"
+        "lsl        %[range]  , %[range]  , %[tmp]          \n\t"
+        "strb       %[r_c]    , [%[state]]                  \n\t"
+        "lsls       %[r_c]    , %[low]    , #16             \n\t"
+        "bne        2f                                      \n\t"
+        "ldr        %[r_c]    , [%[c], %[byte]]             \n\t"
+        "sub        %[tmp]    , %[low]    , #1              \n\t"
+        "eor        %[tmp]    , %[low]    , %[tmp]          \n\t"
+        "lsr        %[tmp]    , %[tmp]    , #15             \n\t"
+        "ldrb       %[r_b]    , [%[r_b], %[tmp]]            \n\t"
+        "ldrh       %[tmp]    , [%[r_c]], #2                \n\t"
+        "str        %[r_c]    , [%[c], %[byte]]             \n\t"
+        "rsb        %[r_b]    , %[r_b]    , #7              \n\t"
+        "rev        %[tmp]    , %[tmp]                      \n\t"
+        "lsr        %[tmp]    , %[tmp]    , #15             \n\t"
+        "sub        %[tmp]    , %[tmp]    , #0x10000        \n\t"
+        "add        %[tmp]    , %[tmp]    , #1              \n\t"
+        "lsl        %[tmp]    , %[tmp]    , %[r_b]          \n\t"
+        "add        %[low]    , %[low]    , %[tmp]          \n\t"
+        "2:                                                 \n\t"
+        :    [bit]"=&r"(bit),
+             [low]"+&r"(*low),
+           [range]"+&r"(*range),
+             [r_b]"=&r"(reg_b),
+             [r_c]"=&r"(reg_c),
+             [tmp]"=&r"(tmp)
+        :      [c]"r"(c),
+           [state]"r"(state),
+          [tables]"r"(ff_h264_cabac_tables),
+            [byte]"M"(offsetof(CABACContext, bytestream)),
+        [norm_off]"I"(H264_NORM_SHIFT_OFFSET),
+         [lps_off]"I"(H264_LPS_RANGE_OFFSET),
+        [mlps_off]"I"(H264_MLPS_STATE_OFFSET + 128)
+        : "memory", "cc"
+    );
+
+    return bit & 1;
+}
+
+#define get_cabac_inline get_cabac_inline_arm
+static av_always_inline int get_cabac_inline_arm(CABACContext *c,
+                                                 uint8_t *const state)
+{
+    int low   = c->low;
+    int range = c->range;
+    int bit   = get_cabac_core_arm(c, &low, &range, state);
+
+    c->low   = low;
+    c->range = range;
+    return bit;
+}
+
+/**
+ * Shift one bit into low, refilling it if needed, and subtract range << 17;
+ * the flags are left set from the subtraction for the bypass decoders.
+ * get_cabac_bypass() compares like the C code (lt) and
+ * get_cabac_bypass_sign() uses the sign of the difference (mi), which only
+ * differ once low has overflowed on a damaged stream.
+ */
+#define CABAC_BYPASS_ARM                                                \
+        "lsl        %[low]    , %[low]    , #1              \n\t"   \
+        "lsls       %[tmp]    , %[low]    , #16             \n\t"   \
+        "bne        1f                                      \n\t"   \
+        "ldr        %[tmp]    , [%[c], %[byte]]             \n\t"   \
+        "ldrh       %[tmp2]   , [%[tmp]], #2                \n\t"   \
+        "str        %[tmp]    , [%[c], %[byte]]             \n\t"   \
+        "rev        %[tmp2]   , %[tmp2]                     \n\t"   \
+        "add        %[low]    , %[low]    , %[tmp2], lsr #15\n\t"   \
+        "sub        %[low]    , %[low]    , #0x10000        \n\t"   \
+        "add        %[low]    , %[low]    , #1              \n\t"   \
+        "1:                                                 \n\t"   \
+        "lsl        %[tmp]    , %[range]  , #17             \n\t"   \
+        "subs       %[low]    , %[low]    , %[tmp]          \n\t"
+
+#define get_cabac_bypass get_cabac_bypass_arm
+static av_always_inline int get_cabac_bypass_arm(CABACContext *c)
+{
+    int bit;
+    void *tmp, *tmp2;
+
+    __asm__ volatile(
+        CABAC_BYPASS_ARM
+        "mov        %[bit]    , #1                          \n\t"
+        "itt        lt                                      \n\t"
+        "addlt      %[low]    , %[low]    , %[tmp]          \n\t"
+        "movlt      %[bit]    , #0                          \n\t"
+        :    [bit]"=&r"(bit),
+             [low]"+&r"(c->low),
+             [tmp]"=&r"(tmp),
+            [tmp2]"=&r"(tmp2)
+        :  [range]"r"(c->range),
+               [c]"r"(c),
+            [byte]"M"(offsetof(CABACContext, bytestream))
+        : "memory", "cc"
+    );
+
+    return bit;
+}
+
+#define get_cabac_bypass_sign get_cabac_bypass_sign_arm
+static av_always_inline int get_cabac_bypass_sign_arm(CABACContext *c, int val)
+{
+    void *tmp, *tmp2;
+
+    __asm__ volatile(
+        CABAC_BYPASS_ARM
+        "itt        mi                                      \n\t"
+        "addmi      %[low]    , %[low]    , %[tmp]          \n\t"
+        "rsbmi      %[val]    , %[val]    , #0              \n\t"
+        :    [val]"+&r"(val),
+             [low]"+&r"(c->low),
+             [tmp]"=&r"(tmp),
+            [tmp2]"=&r"(tmp2)
+        :  [range]"r"(c->range),
+               [c]"r"(c),
+            [byte]"M"(offsetof(CABACContext, bytestream))
+        : "memory", "cc"
+    );
+
+    return val;
+}
+
+#endif /* HAVE_ARMV6_INLINE && CABAC_BITS == 16 && !HAVE_BIGENDIAN */
+
+#endif /* AVCODEC_ARM_CABAC_H */
@@ -0,0 +1,91 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * H.264 CABAC significance map decoding, ARM optimized.
+ * low and range stay in registers for the whole map instead of being
+ * reloaded from the context for every bin.
+ */
+
+#ifndef AVCODEC_ARM_H264_CABAC_H
+#define AVCODEC_ARM_H264_CABAC_H
+
+#include <stdint.h>
+
+#include "libavcodec/cabac.h"
+#include "cabac.h"
+
+#if HAVE_ARMV6_INLINE && CABAC_BITS == 16 && !HAVE_BIGENDIAN
+
+#define decode_significance decode_significance_arm
+static int decode_significance_arm(CABACContext *c, int max_coeff,
+                                   uint8_t *significant_coeff_ctx_base,
+                                   int *index, intptr_t last_off)
+{
+    int low   = c->low;
+    int range = c->range;
+    int coeff_count = 0;
+    int last;
+
+    for (last = 0; last < max_coeff - 1; last++) {
+        uint8_t *sig_ctx = significant_coeff_ctx_base + last;
+        if (get_cabac_core_arm(c, &low, &range, sig_ctx)) {
+            index[coeff_count++] = last;
+            if (get_cabac_core_arm(c, &low, &range, sig_ctx + last_off))
+                goto end;
+        }
+    }
+    index[coeff_count++] = last;
+end:
+    c->low   = low;
+    c->range = range;
+    return coeff_count;
+}
+
+#define decode_significance_8x8 decode_significance_8x8_arm
+static int decode_significance_8x8_arm(CABACContext *c,
+                                       uint8_t *significant_coeff_ctx_base,
+                                       int *index, uint8_t *last_coeff_ctx_base,
+                                       const uint8_t *sig_off)
+{
+    const uint8_t *last_off = ff_h264_cabac_tables + H264_LAST_COEFF_FLAG_OFFSET_8x8_OFFSET;
+    int low   = c->low;
+    int range = c->range;
+    int coeff_count = 0;
+    int last;
+
+    for (last = 0; last < 63; last++) {
+        if (get_cabac_core_arm(c, &low, &range,
+                               significant_coeff_ctx_base + sig_off[last])) {
+            index[coeff_count++] = last;
+            if (get_cabac_core_arm(c, &low, &range,
+                                   last_coeff_ctx_base + last_off[last]))
+                goto end;
+        }
+    }
+    index[coeff_count++] = last;
+end:
+    c->low   = low;
+    c->range = range;
+    return coeff_count;
+}
+
+#endif /* HAVE_ARMV6_INLINE && CABAC_BITS == 16 && !HAVE_BIGENDIAN */
+
+#endif /* AVCODEC_ARM_H264_CABAC_H */
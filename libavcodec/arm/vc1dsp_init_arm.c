@@ -0,0 +1,127 @@
+/*
+ * VC-1 and WMV3 decoder - DSP functions, ARM optimized
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/arm/cpu.h"
+#include "libavcodec/vc1dsp.h"
+
+void ff_vc1_inv_trans_8x8_neon(int16_t *block);
+void ff_vc1_inv_trans_8x4_neon(uint8_t *dest, int linesize, int16_t *block);
+void ff_vc1_inv_trans_4x8_neon(uint8_t *dest, int linesize, int16_t *block);
+void ff_vc1_inv_trans_4x4_neon(uint8_t *dest, int linesize, int16_t *block);
+
+void ff_vc1_inv_trans_8x8_dc_neon(uint8_t *dest, int linesize, int16_t *block);
+void ff_vc1_inv_trans_8x4_dc_neon(uint8_t *dest, int linesize, int16_t *block);
+void ff_vc1_inv_trans_4x8_dc_neon(uint8_t *dest, int linesize, int16_t *block);
+void ff_vc1_inv_trans_4x4_dc_neon(uint8_t *dest, int linesize, int16_t *block);
+
+void ff_vc1_v_loop_filter4_neon(uint8_t *src, int stride, int pq);
+void ff_vc1_h_loop_filter4_neon(uint8_t *src, int stride, int pq);
+void ff_vc1_v_loop_filter8_neon(uint8_t *src, int stride, int pq);
+void ff_vc1_h_loop_filter8_neon(uint8_t *src, int stride, int pq);
+void ff_vc1_v_loop_filter16_neon(uint8_t *src, int stride, int pq);
+void ff_vc1_h_loop_filter16_neon(uint8_t *src, int stride, int pq);
+
+#define DECL_MSPEL(type, hv)                                            \
+    void ff_##type##_vc1_mspel_mc##hv##_neon(uint8_t *dst,              \
+                                             const uint8_t *src,        \
+                                             ptrdiff_t stride, int rnd)
+#define DECL_MSPEL2(hv)                         \
+    DECL_MSPEL(put, hv);                        \
+    DECL_MSPEL(avg, hv)
+
+DECL_MSPEL2(00);
+DECL_MSPEL2(10);
+DECL_MSPEL2(20);
+DECL_MSPEL2(30);
+DECL_MSPEL2(01);
+DECL_MSPEL2(11);
+DECL_MSPEL2(21);
+DECL_MSPEL2(31);
+DECL_MSPEL2(02);
+DECL_MSPEL2(12);
+DECL_MSPEL2(22);
+DECL_MSPEL2(32);
+DECL_MSPEL2(03);
+DECL_MSPEL2(13);
+DECL_MSPEL2(23);
+DECL_MSPEL2(33);
+
+void ff_put_vc1_chroma_mc8_neon(uint8_t *, uint8_t *, int, int, int, int);
+void ff_put_vc1_chroma_mc4_neon(uint8_t *, uint8_t *, int, int, int, int);
+
+void ff_avg_vc1_chroma_mc8_neon(uint8_t *, uint8_t *, int, int, int, int);
+void ff_avg_vc1_chroma_mc4_neon(uint8_t *, uint8_t *, int, int, int, int);
+
+#define FN_ASSIGN(hv, idx)                                                 \
+    dsp->put_vc1_mspel_pixels_tab[idx] = ff_put_vc1_mspel_mc##hv##_neon;   \
+    dsp->avg_vc1_mspel_pixels_tab[idx] = ff_avg_vc1_mspel_mc##hv##_neon
+
+static av_cold void vc1dsp_init_neon(VC1DSPContext *dsp)
+{
+    dsp->vc1_inv_trans_8x8    = ff_vc1_inv_trans_8x8_neon;
+    dsp->vc1_inv_trans_8x4    = ff_vc1_inv_trans_8x4_neon;
+    dsp->vc1_inv_trans_4x8    = ff_vc1_inv_trans_4x8_neon;
+    dsp->vc1_inv_trans_4x4    = ff_vc1_inv_trans_4x4_neon;
+    dsp->vc1_inv_trans_8x8_dc = ff_vc1_inv_trans_8x8_dc_neon;
+    dsp->vc1_inv_trans_8x4_dc = ff_vc1_inv_trans_8x4_dc_neon;
+    dsp->vc1_inv_trans_4x8_dc = ff_vc1_inv_trans_4x8_dc_neon;
+    dsp->vc1_inv_trans_4x4_dc = ff_vc1_inv_trans_4x4_dc_neon;
+
+    dsp->vc1_v_loop_filter4   = ff_vc1_v_loop_filter4_neon;
+    dsp->vc1_h_loop_filter4   = ff_vc1_h_loop_filter4_neon;
+    dsp->vc1_v_loop_filter8   = ff_vc1_v_loop_filter8_neon;
+    dsp->vc1_h_loop_filter8   = ff_vc1_h_loop_filter8_neon;
+    dsp->vc1_v_loop_filter16  = ff_vc1_v_loop_filter16_neon;
+    dsp->vc1_h_loop_filter16  = ff_vc1_h_loop_filter16_neon;
+
+    FN_ASSIGN(00,  0);
+    FN_ASSIGN(10,  1);
+    FN_ASSIGN(20,  2);
+    FN_ASSIGN(30,  3);
+    FN_ASSIGN(01,  4);
+    FN_ASSIGN(11,  5);
+    FN_ASSIGN(21,  6);
+    FN_ASSIGN(31,  7);
+    FN_ASSIGN(02,  8);
+    FN_ASSIGN(12,  9);
+    FN_ASSIGN(22, 10);
+    FN_ASSIGN(32, 11);
+    FN_ASSIGN(03, 12);
+    FN_ASSIGN(13, 13);
+    FN_ASSIGN(23, 14);
+    FN_ASSIGN(33, 15);
+
+    dsp->put_no_rnd_vc1_chroma_pixels_tab[0] = ff_put_vc1_chroma_mc8_neon;
+    dsp->avg_no_rnd_vc1_chroma_pixels_tab[0] = ff_avg_vc1_chroma_mc8_neon;
+    dsp->put_no_rnd_vc1_chroma_pixels_tab[1] = ff_put_vc1_chroma_mc4_neon;
+    dsp->avg_no_rnd_vc1_chroma_pixels_tab[1] = ff_avg_vc1_chroma_mc4_neon;
+}
+
+av_cold void ff_vc1dsp_init_arm(VC1DSPContext *dsp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (have_neon(cpu_flags))
+        vc1dsp_init_neon(dsp);
+}
@@ -32,6 +32,9 @@
 #include "cabac.h"
 #include "config.h"
 
+#if ARCH_ARM
+#   include "arm/cabac.h"
+#endif
 #if ARCH_X86
 #   include "x86/cabac.h"
 #endif
@@ -111,6 +114,7 @@ static int av_unused get_cabac(CABACContext *c, uint8_t * const state){
     return get_cabac_inline(c,state);
 }
 
+#ifndef get_cabac_bypass
 static int av_unused get_cabac_bypass(CABACContext *c){
     int range;
     c->low += c->low;
@@ -126,6 +130,7 @@ static int av_unused get_cabac_bypass(CABACContext *c){
         return 1;
     }
 }
+#endif
 
 
 #ifndef get_cabac_bypass_sign
@@ -122,7 +122,14 @@ int ff_frame_thread_encoder_init(AVCodecContext *avctx, AVDictionary *options){
 
 
     if(   !(avctx->thread_type & FF_THREAD_FRAME)
-       || !(avctx->codec->capabilities & CODEC_CAP_INTRA_ONLY))
+       || !(avctx->codec->capabilities & CODEC_CAP_INTRA_ONLY)
+       && !((avctx->codec->capabilities & CODEC_CAP_FRAME_THREADS) && avctx->gop_size <= 1))
+        return 0;
+
+    // first pass statistics and adaptive context models are carried from
+    // one frame to the next, so they need all frames in a single context
+    if(   (avctx->flags & CODEC_FLAG_PASS1)
+       || ((avctx->codec_id == AV_CODEC_ID_HUFFYUV || avctx->codec_id == AV_CODEC_ID_FFVHUFF) && avctx->context_model))
         return 0;
 
     if(!avctx->thread_count) {
@@ -39,6 +39,9 @@
 #include "golomb.h"
 #include "libavutil/avassert.h"
 
+#if ARCH_ARM
+#include "arm/h264_cabac.h"
+#endif
 #if ARCH_X86
 #include "x86/h264_i386.h"
 #endif
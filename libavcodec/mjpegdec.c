@@ -39,6 +39,7 @@
 #include "mjpeg.h"
 #include "mjpegdec.h"
 #include "jpeglsdec.h"
+#include "thread.h"
 
 
 static int build_vlc(VLC *vlc, const uint8_t *bits_table,
@@ -80,6 +81,23 @@ static void build_basic_mjpeg_vlc(MJpegDecodeContext *s)
               avpriv_mjpeg_val_ac_chrominance, 251, 0, 0);
 }
 
+static av_cold void init_default_huffman_tables(MJpegDecodeContext *s)
+{
+    AVCodecContext *avctx = s->avctx;
+
+    build_basic_mjpeg_vlc(s);
+
+    if (s->extern_huff) {
+        av_log(avctx, AV_LOG_INFO, "using external huffman table\n");
+        init_get_bits(&s->gb, avctx->extradata, avctx->extradata_size * 8);
+        if (ff_mjpeg_decode_dht(s)) {
+            av_log(avctx, AV_LOG_ERROR,
+                   "error using external huffman table, switching back to internal\n");
+            build_basic_mjpeg_vlc(s);
+        }
+    }
+}
+
 av_cold int ff_mjpeg_decode_init(AVCodecContext *avctx)
 {
     MJpegDecodeContext *s = avctx->priv_data;
@@ -100,17 +118,8 @@ av_cold int ff_mjpeg_decode_init(AVCodecContext *avctx)
     s->org_height    = avctx->coded_height;
     avctx->chroma_sample_location = AVCHROMA_LOC_CENTER;
 
-    build_basic_mjpeg_vlc(s);
+    init_default_huffman_tables(s);
 
-    if (s->extern_huff) {
-        av_log(avctx, AV_LOG_INFO, "using external huffman table\n");
-        init_get_bits(&s->gb, avctx->extradata, avctx->extradata_size * 8);
-        if (ff_mjpeg_decode_dht(s)) {
-            av_log(avctx, AV_LOG_ERROR,
-                   "error using external huffman table, switching back to internal\n");
-            build_basic_mjpeg_vlc(s);
-        }
-    }
     if (avctx->field_order == AV_FIELD_BB) { /* quicktime icefloe 019 */
         s->interlace_polarity = 1;           /* bottom field first */
         av_log(avctx, AV_LOG_DEBUG, "bottom field first\n");
@@ -121,6 +130,74 @@ av_cold int ff_mjpeg_decode_init(AVCodecContext *avctx)
     return 0;
 }
 
+av_cold int ff_mjpeg_decode_init_thread_copy(AVCodecContext *avctx)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+
+    s->avctx       = avctx;
+    s->picture_ptr = &s->picture;
+    avcodec_get_frame_defaults(&s->picture);
+    memset(s->vlcs, 0, sizeof(s->vlcs));
+    init_default_huffman_tables(s);
+
+    return 0;
+}
+
+static int copy_vlc(VLC *dst, const VLC *src)
+{
+    ff_free_vlc(dst);
+    if (!src->table)
+        return 0;
+
+    dst->table = av_malloc_array(src->table_allocated, sizeof(*dst->table));
+    if (!dst->table)
+        return AVERROR(ENOMEM);
+    memcpy(dst->table, src->table, src->table_size * sizeof(*dst->table));
+    dst->bits            = src->bits;
+    dst->table_size      = src->table_size;
+    dst->table_allocated = src->table_allocated;
+
+    return 0;
+}
+
+/**
+ * Propagate the state a picture may inherit from the previous ones:
+ * quantization and huffman tables, dimensions and the field layout.
+ */
+int ff_mjpeg_decode_update_thread_context(AVCodecContext *dst,
+                                          const AVCodecContext *src)
+{
+    MJpegDecodeContext *s = dst->priv_data, *s1 = src->priv_data;
+    int i, j, ret;
+
+    if (dst == src)
+        return 0;
+
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 4; j++)
+            if ((ret = copy_vlc(&s->vlcs[i][j], &s1->vlcs[i][j])) < 0)
+                return ret;
+    memcpy(s->quant_matrixes, s1->quant_matrixes, sizeof(s->quant_matrixes));
+    memcpy(s->qscale,         s1->qscale,         sizeof(s->qscale));
+    memcpy(s->h_count,        s1->h_count,        sizeof(s->h_count));
+    memcpy(s->v_count,        s1->v_count,        sizeof(s->v_count));
+
+    s->width              = s1->width;
+    s->height             = s1->height;
+    s->first_picture      = s1->first_picture;
+    s->interlaced         = s1->interlaced;
+    s->bottom_field       = s1->bottom_field;
+    s->interlace_polarity = s1->interlace_polarity;
+    s->rgb                = s1->rgb;
+    s->rct                = s1->rct;
+    s->pegasus_rct        = s1->pegasus_rct;
+    s->buggy_avid         = s1->buggy_avid;
+    s->cs_itu601          = s1->cs_itu601;
+    s->flipped            = s1->flipped;
+
+    return 0;
+}
+
 
 /* quantize tables */
 int ff_mjpeg_decode_dqt(MJpegDecodeContext *s)
@@ -215,6 +292,7 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
     int len, nb_components, i, width, height, pix_fmt_id;
     int h_count[MAX_COMPONENTS];
     int v_count[MAX_COMPONENTS];
+    ThreadFrame frame = { .f = s->picture_ptr };
 
     s->cur_scan = 0;
     s->upscale_h = s->upscale_v = 0;
@@ -447,7 +525,7 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
     }
 
     av_frame_unref(s->picture_ptr);
-    if (ff_get_buffer(s->avctx, s->picture_ptr, AV_GET_BUFFER_FLAG_REF) < 0)
+    if (ff_thread_get_buffer(s->avctx, &frame, AV_GET_BUFFER_FLAG_REF) < 0)
         return -1;
     s->picture_ptr->pict_type = AV_PICTURE_TYPE_I;
     s->picture_ptr->key_frame = 1;
@@ -1009,11 +1087,194 @@ static av_always_inline void mjpeg_copy_block(MJpegDecodeContext *s,
     }
 }
 
+static av_always_inline int decode_mcu(MJpegDecodeContext *s,
+                                       int nb_components, int Ah, int Al,
+                                       uint8_t *data[],
+                                       const uint8_t *reference_data[],
+                                       const int linesize[],
+                                       int mb_x, int mb_y, int copy_mb)
+{
+    int i;
+
+    for (i = 0; i < nb_components; i++) {
+        uint8_t *ptr;
+        int n, h, v, x, y, c, j;
+        int block_offset;
+        n = s->nb_blocks[i];
+        c = s->comp_index[i];
+        h = s->h_scount[i];
+        v = s->v_scount[i];
+        x = 0;
+        y = 0;
+        for (j = 0; j < n; j++) {
+            block_offset = (((linesize[c] * (v * mb_y + y) * 8) +
+                             (h * mb_x + x) * 8) >> s->avctx->lowres);
+
+            if (s->interlaced && s->bottom_field)
+                block_offset += linesize[c] >> 1;
+            ptr = data[c] + block_offset;
+            if (!s->progressive) {
+                if (copy_mb)
+                    mjpeg_copy_block(s, ptr, reference_data[c] + block_offset,
+                                     linesize[c], s->avctx->lowres);
+
+                else {
+                    s->dsp.clear_block(s->block);
+                    if (decode_block(s, s->block, i,
+                                     s->dc_index[i], s->ac_index[i],
+                                     s->quant_matrixes[s->quant_index[c]]) < 0) {
+                        av_log(s->avctx, AV_LOG_ERROR,
+                               "error y=%d x=%d\n", mb_y, mb_x);
+                        return AVERROR_INVALIDDATA;
+                    }
+                    s->dsp.idct_put(ptr, linesize[c], s->block);
+                }
+            } else {
+                int block_idx  = s->block_stride[c] * (v * mb_y + y) +
+                                 (h * mb_x + x);
+                int16_t *block = s->blocks[c][block_idx];
+                if (Ah)
+                    block[0] += get_bits1(&s->gb) *
+                                s->quant_matrixes[s->quant_index[c]][0] << Al;
+                else if (decode_dc_progressive(s, block, i, s->dc_index[i],
+                                               s->quant_matrixes[s->quant_index[c]],
+                                               Al) < 0) {
+                    av_log(s->avctx, AV_LOG_ERROR,
+                           "error y=%d x=%d\n", mb_y, mb_x);
+                    return AVERROR_INVALIDDATA;
+                }
+            }
+            av_dlog(s->avctx, "mb: %d %d processed\n", mb_y, mb_x);
+            av_dlog(s->avctx, "%d %d %d %d %d %d %d %d \n",
+                    mb_x, mb_y, x, y, c, s->bottom_field,
+                    (v * mb_y + y) * 8, (h * mb_x + x) * 8);
+            if (++x == h) {
+                x = 0;
+                y++;
+            }
+        }
+    }
+    return 0;
+}
+
+#define MAX_RESTART_JOBS 32
+
+typedef struct MJpegRestartJobs {
+    int nb_components;
+    uint8_t *data[MAX_COMPONENTS];
+    int linesize[MAX_COMPONENTS];
+    const uint8_t *scan_start;  ///< first byte of the entropy coded data
+    const uint8_t *scan_end;
+    int nb_intervals;
+    int nb_jobs;
+} MJpegRestartJobs;
+
+/**
+ * Decode a contiguous range of restart intervals. Each interval starts
+ * right after its RSTn marker with the DC predictors reset, so it only
+ * depends on the picture level state shared by all jobs.
+ */
+static int decode_restart_intervals(AVCodecContext *avctx, void *arg,
+                                    int jobnr, int threadnr)
+{
+    MJpegRestartJobs *jobs  = arg;
+    MJpegDecodeContext *s0 = avctx->priv_data;
+    MJpegDecodeContext *s  = &s0->slice_ctx[jobnr];
+    const int nb_mcus = s0->mb_width * s0->mb_height;
+    const int first   = jobs->nb_intervals *  jobnr      / jobs->nb_jobs;
+    const int last    = jobs->nb_intervals * (jobnr + 1) / jobs->nb_jobs;
+    int i, k, mcu, ret;
+
+    memcpy(s, s0, sizeof(*s));
+
+    for (k = first; k < last; k++) {
+        const uint8_t *start = k ? s0->buffer + s0->restart_pos[k - 1] + 2
+                                 : jobs->scan_start;
+        const uint8_t *end   = k < jobs->nb_intervals - 1
+                                 ? s0->buffer + s0->restart_pos[k]
+                                 : jobs->scan_end;
+        const int mcu_end    = FFMIN((k + 1) * s->restart_interval, nb_mcus);
+
+        if ((ret = init_get_bits8(&s->gb, start, end - start)) < 0)
+            return ret;
+        for (i = 0; i < jobs->nb_components; i++)
+            s->last_dc[i] = 1024;
+
+        for (mcu = k * s->restart_interval; mcu < mcu_end; mcu++) {
+            const int mb_x = mcu % s->mb_width;
+            const int mb_y = mcu / s->mb_width;
+
+            if (get_bits_left(&s->gb) < 0) {
+                av_log(avctx, AV_LOG_ERROR, "overread %d\n",
+                       -get_bits_left(&s->gb));
+                return AVERROR_INVALIDDATA;
+            }
+            if ((ret = decode_mcu(s, jobs->nb_components, 0, 0, jobs->data,
+                                  NULL, jobs->linesize, mb_x, mb_y, 0)) < 0)
+                return ret;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Check that the RSTn markers found while unescaping the scan delimit
+ * every restart interval of the picture, in sequence. Some encoders
+ * also terminate the last interval with a marker, it ends the scan.
+ */
+static int restart_markers_valid(MJpegDecodeContext *s,
+                                 MJpegRestartJobs *jobs)
+{
+    int k;
+
+    if (s->nb_restart_pos < jobs->nb_intervals - 1)
+        return 0;
+    if (s->nb_restart_pos >= jobs->nb_intervals)
+        jobs->scan_end = s->buffer + s->restart_pos[jobs->nb_intervals - 1];
+    for (k = 0; k < jobs->nb_intervals - 1; k++) {
+        const uint8_t *marker = s->buffer + s->restart_pos[k];
+        if (marker < jobs->scan_start || marker >= jobs->scan_end ||
+            marker[1] != RST0 + (k & 7))
+            return 0;
+    }
+    return 1;
+}
+
+static int mjpeg_decode_scan_threaded(MJpegDecodeContext *s,
+                                      MJpegRestartJobs *jobs)
+{
+    int ret[MAX_RESTART_JOBS];
+    int i, consumed;
+
+    jobs->nb_jobs = FFMIN3(jobs->nb_intervals, s->avctx->thread_count,
+                           MAX_RESTART_JOBS);
+    av_fast_malloc(&s->slice_ctx, &s->slice_ctx_size,
+                   jobs->nb_jobs * sizeof(*s->slice_ctx));
+    if (!s->slice_ctx)
+        return AVERROR(ENOMEM);
+
+    s->avctx->execute2(s->avctx, decode_restart_intervals, jobs, ret,
+                       jobs->nb_jobs);
+
+    /* leave the bit reader where the sequential decoder stops, past a
+     * terminating RSTn */
+    consumed = jobs->scan_end - s->gb.buffer;
+    if (jobs->scan_end < s->gb.buffer_end - 1 &&
+        jobs->scan_end[1] == RST0 + ((jobs->nb_intervals - 1) & 7))
+        consumed += 2;
+    skip_bits_long(&s->gb, 8 * consumed - get_bits_count(&s->gb));
+
+    for (i = 0; i < jobs->nb_jobs; i++)
+        if (ret[i] < 0)
+            return ret[i];
+    return 0;
+}
+
 static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
                              int Al, const uint8_t *mb_bitmask,
                              const AVFrame *reference)
 {
-    int i, mb_x, mb_y;
+    int i, mb_x, mb_y, ret;
     uint8_t *data[MAX_COMPONENTS];
     const uint8_t *reference_data[MAX_COMPONENTS];
     int linesize[MAX_COMPONENTS];
@@ -1043,6 +1304,23 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
         }
     }
 
+    if (s->restart_interval && !s->progressive && !mb_bitmask &&
+        s->avctx->active_thread_type & FF_THREAD_SLICE) {
+        MJpegRestartJobs jobs = {
+            .nb_components = nb_components,
+            .scan_start    = s->gb.buffer + (get_bits_count(&s->gb) >> 3),
+            .scan_end      = s->gb.buffer_end,
+            .nb_intervals  = (s->mb_width * s->mb_height +
+                              s->restart_interval - 1) / s->restart_interval,
+        };
+        memcpy(jobs.data,     data,     sizeof(data));
+        memcpy(jobs.linesize, linesize, sizeof(linesize));
+
+        if (jobs.nb_intervals > 1 && s->gb.buffer == s->buffer &&
+            restart_markers_valid(s, &jobs))
+            return mjpeg_decode_scan_threaded(s, &jobs);
+    }
+
     for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
         for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
             const int copy_mb = mb_bitmask && !get_bits1(&mb_bitmask_gb);
@@ -1055,64 +1333,10 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
                        -get_bits_left(&s->gb));
                 return AVERROR_INVALIDDATA;
             }
-            for (i = 0; i < nb_components; i++) {
-                uint8_t *ptr;
-                int n, h, v, x, y, c, j;
-                int block_offset;
-                n = s->nb_blocks[i];
-                c = s->comp_index[i];
-                h = s->h_scount[i];
-                v = s->v_scount[i];
-                x = 0;
-                y = 0;
-                for (j = 0; j < n; j++) {
-                    block_offset = (((linesize[c] * (v * mb_y + y) * 8) +
-                                     (h * mb_x + x) * 8) >> s->avctx->lowres);
-
-                    if (s->interlaced && s->bottom_field)
-                        block_offset += linesize[c] >> 1;
-                    ptr = data[c] + block_offset;
-                    if (!s->progressive) {
-                        if (copy_mb)
-                            mjpeg_copy_block(s, ptr, reference_data[c] + block_offset,
-                                             linesize[c], s->avctx->lowres);
-
-                        else {
-                            s->dsp.clear_block(s->block);
-                            if (decode_block(s, s->block, i,
-                                             s->dc_index[i], s->ac_index[i],
-                                             s->quant_matrixes[s->quant_index[c]]) < 0) {
-                                av_log(s->avctx, AV_LOG_ERROR,
-                                       "error y=%d x=%d\n", mb_y, mb_x);
-                                return AVERROR_INVALIDDATA;
-                            }
-                            s->dsp.idct_put(ptr, linesize[c], s->block);
-                        }
-                    } else {
-                        int block_idx  = s->block_stride[c] * (v * mb_y + y) +
-                                         (h * mb_x + x);
-                        int16_t *block = s->blocks[c][block_idx];
-                        if (Ah)
-                            block[0] += get_bits1(&s->gb) *
-                                        s->quant_matrixes[s->quant_index[c]][0] << Al;
-                        else if (decode_dc_progressive(s, block, i, s->dc_index[i],
-                                                       s->quant_matrixes[s->quant_index[c]],
-                                                       Al) < 0) {
-                            av_log(s->avctx, AV_LOG_ERROR,
-                                   "error y=%d x=%d\n", mb_y, mb_x);
-                            return AVERROR_INVALIDDATA;
-                        }
-                    }
-                    av_dlog(s->avctx, "mb: %d %d processed\n", mb_y, mb_x);
-                    av_dlog(s->avctx, "%d %d %d %d %d %d %d %d \n",
-                            mb_x, mb_y, x, y, c, s->bottom_field,
-                            (v * mb_y + y) * 8, (h * mb_x + x) * 8);
-                    if (++x == h) {
-                        x = 0;
-                        y++;
-                    }
-                }
-            }
+            if ((ret = decode_mcu(s, nb_components, Ah, Al, data,
+                                  reference_data, linesize,
+                                  mb_x, mb_y, copy_mb)) < 0)
+                return ret;
 
             handle_rstn(s, nb_components);
         }
@@ -1272,6 +1496,12 @@ int ff_mjpeg_decode_sos(MJpegDecodeContext *s, const uint8_t *mb_bitmask,
                s->pegasus_rct ? "PRCT" : (s->rct ? "RCT" : ""), nb_components);
 
 
+    /* a picture coded in a single scan has parsed everything the next
+     * one can inherit once it reaches its scan */
+    if (!s->progressive && !s->ls && !s->interlaced &&
+        nb_components == s->nb_components)
+        ff_thread_finish_setup(s->avctx);
+
     /* mjpeg-b can have padding bytes between sos and image data, skip them */
     for (i = s->mjpb_skiptosod; i > 0; i--)
         skip_bits(&s->gb, 8);
@@ -1542,6 +1772,19 @@ found:
     return val;
 }
 
+static int add_restart_pos(MJpegDecodeContext *s, int pos)
+{
+    int *tmp = av_fast_realloc(s->restart_pos, &s->restart_pos_size,
+                               (s->nb_restart_pos + 1) * sizeof(*s->restart_pos));
+    if (!tmp) {
+        s->nb_restart_pos = 0;
+        return 0;
+    }
+    s->restart_pos = tmp;
+    s->restart_pos[s->nb_restart_pos++] = pos;
+    return 1;
+}
+
 int ff_mjpeg_find_marker(MJpegDecodeContext *s,
                          const uint8_t **buf_ptr, const uint8_t *buf_end,
                          const uint8_t **unescaped_buf_ptr,
@@ -1558,7 +1801,11 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
     if (start_code == SOS && !s->ls) {
         const uint8_t *src = *buf_ptr;
         uint8_t *dst = s->buffer;
+        /* the restart intervals can only be located in the unescaped
+         * data while unescaping it */
+        int record_rst = s->avctx->active_thread_type & FF_THREAD_SLICE;
 
+        s->nb_restart_pos = 0;
         while (src < buf_end) {
             uint8_t x = *(src++);
 
@@ -1568,9 +1815,11 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
                     while (src < buf_end && x == 0xff)
                         x = *(src++);
 
-                    if (x >= 0xd0 && x <= 0xd7)
+                    if (x >= 0xd0 && x <= 0xd7) {
                         *(dst++) = x;
-                    else if (x)
+                        if (record_rst)
+                            record_rst = add_restart_pos(s, dst - 2 - s->buffer);
+                    } else if (x)
                         break;
                 }
             }
@@ -1895,6 +2144,10 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
         av_freep(&s->blocks[i]);
         av_freep(&s->last_nnz[i]);
     }
+    av_freep(&s->restart_pos);
+    s->restart_pos_size = 0;
+    av_freep(&s->slice_ctx);
+    s->slice_ctx_size = 0;
     return 0;
 }
 
@@ -1929,9 +2182,12 @@ AVCodec ff_mjpeg_decoder = {
     .close          = ff_mjpeg_decode_end,
     .decode         = ff_mjpeg_decode_frame,
     .flush          = decode_flush,
-    .capabilities   = CODEC_CAP_DR1,
+    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_FRAME_THREADS |
+                      CODEC_CAP_SLICE_THREADS,
     .max_lowres     = 3,
     .long_name      = NULL_IF_CONFIG_SMALL("MJPEG (Motion JPEG)"),
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(ff_mjpeg_decode_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(ff_mjpeg_decode_update_thread_context),
     .priv_class     = &mjpegdec_class,
 };
 #endif
@@ -102,6 +102,11 @@ typedef struct MJpegDecodeContext {
 
     int restart_interval;
     int restart_count;
+    int *restart_pos;                   ///< offsets of the RSTn markers in the unescaped scan
+    unsigned int restart_pos_size;
+    int nb_restart_pos;
+    struct MJpegDecodeContext *slice_ctx; ///< per-job copies for decoding restart intervals in parallel
+    unsigned int slice_ctx_size;
 
     int buggy_avid;
     int cs_itu601;
@@ -120,6 +125,9 @@ typedef struct MJpegDecodeContext {
 
 int ff_mjpeg_decode_init(AVCodecContext *avctx);
 int ff_mjpeg_decode_end(AVCodecContext *avctx);
+int ff_mjpeg_decode_init_thread_copy(AVCodecContext *avctx);
+int ff_mjpeg_decode_update_thread_context(AVCodecContext *dst,
+                                          const AVCodecContext *src);
 int ff_mjpeg_decode_frame(AVCodecContext *avctx,
                           void *data, int *got_frame,
                           AVPacket *avpkt);
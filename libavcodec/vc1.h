@@ -398,6 +398,8 @@ typedef struct VC1Context{
 
     int end_mb_x;                ///< Horizontal macroblock limit (used only by mss2)
 
+    struct VC1Context **slice_ctx; ///< NULL-terminated per-thread contexts for slice threading
+
     int parse_only;              ///< Context is used within parser
 } VC1Context;
 
@@ -38,6 +38,7 @@
 #include "msmpeg4data.h"
 #include "unary.h"
 #include "mathops.h"
+#include "thread.h"
 #include "vdpau_internal.h"
 #include "libavutil/avassert.h"
 
@@ -4724,6 +4725,47 @@ static int vc1_decode_b_mb_intfr(VC1Context *v)
     return 0;
 }
 
+/** Tell the frame threads which rows of the current progressive reference
+ *  frame are final.
+ *  The overlap smoothing and the loop filter run up to two rows behind the
+ *  MB decoding loop, so callers pass the current row minus two inside a slice.
+ */
+static void vc1_report_decode_progress(VC1Context *v, int mb_y)
+{
+    MpegEncContext *s = &v->s;
+
+    if (HAVE_THREADS && s->avctx->active_thread_type & FF_THREAD_FRAME &&
+        v->fcm == PROGRESSIVE && s->pict_type != AV_PICTURE_TYPE_B &&
+        !s->er.error_occurred)
+        ff_thread_report_progress(&s->current_picture_ptr->tf, mb_y, 0);
+}
+
+/** Wait until the reference frames are decoded down to the lowest row the
+ *  current MB row can predict from.
+ *  Only progressive frames are tracked row by row, interlaced ones wait
+ *  for the whole reference.
+ */
+static void vc1_await_references(VC1Context *v)
+{
+    MpegEncContext *s = &v->s;
+    int row = INT_MAX;
+
+    if (!(HAVE_THREADS && s->avctx->active_thread_type & FF_THREAD_FRAME))
+        return;
+
+    if (v->fcm == PROGRESSIVE) {
+        /* MVs are in quarter-pel units; direct mode scales the MVs of the
+         * next anchor, whose range is unknown here, so assume the largest
+         * one for B-frames. 3 more lines cover the bicubic filter taps. */
+        int range = s->pict_type == AV_PICTURE_TYPE_B ? 1 << 10 : v->range_y;
+        row = FFMIN((s->mb_y * 16 + 15 + 3 + (range >> 2)) >> 4, s->mb_height - 1);
+    }
+    if (s->last_picture_ptr)
+        ff_thread_await_progress(&s->last_picture_ptr->tf, row, 0);
+    if (s->pict_type == AV_PICTURE_TYPE_B && s->next_picture_ptr)
+        ff_thread_await_progress(&s->next_picture_ptr->tf, row, 0);
+}
+
 /** Decode blocks of I-frame
  */
 static void vc1_decode_i_blocks(VC1Context *v)
@@ -4855,9 +4897,11 @@ static void vc1_decode_i_blocks(VC1Context *v)
             ff_mpeg_draw_horiz_band(s, (s->mb_y - 1) * 16, 16);
 
         s->first_slice_line = 0;
+        vc1_report_decode_progress(v, s->mb_y - 2);
     }
     if (v->s.loop_filter)
         ff_mpeg_draw_horiz_band(s, (s->end_mb_y - 1) * 16, 16);
+    vc1_report_decode_progress(v, s->end_mb_y - 1);
 
     /* This is intentionally mb_height and not end_mb_y - unlike in advanced
      * profile, these only differ are when decoding MSS2 rectangles. */
@@ -4982,6 +5026,7 @@ static void vc1_decode_i_blocks_adv(VC1Context *v)
         else if (s->mb_y)
             ff_mpeg_draw_horiz_band(s, (s->mb_y-1) * 16, 16);
         s->first_slice_line = 0;
+        vc1_report_decode_progress(v, s->mb_y - 2);
     }
 
     /* raw bottom MB row */
@@ -4996,6 +5041,7 @@ static void vc1_decode_i_blocks_adv(VC1Context *v)
     }
     if (v->s.loop_filter)
         ff_mpeg_draw_horiz_band(s, (s->end_mb_y-1)*16, 16);
+    vc1_report_decode_progress(v, s->end_mb_y - 1);
     ff_er_add_slice(&s->er, 0, s->start_mb_y << v->field_mode, s->mb_width - 1,
                     (s->end_mb_y << v->field_mode) - 1, ER_MB_END);
 }
@@ -5037,6 +5083,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
     for (s->mb_y = s->start_mb_y; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x = 0;
         init_block_index(v);
+        vc1_await_references(v);
         for (; s->mb_x < s->mb_width; s->mb_x++) {
             ff_update_block_index(s);
 
@@ -5061,6 +5108,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
         memmove(v->luma_mv_base,  v->luma_mv,  sizeof(v->luma_mv_base[0])  * s->mb_stride);
         if (s->mb_y != s->start_mb_y) ff_mpeg_draw_horiz_band(s, (s->mb_y - 1) * 16, 16);
         s->first_slice_line = 0;
+        vc1_report_decode_progress(v, s->mb_y - 2);
     }
     if (apply_loop_filter) {
         s->mb_x = 0;
@@ -5072,6 +5120,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
     }
     if (s->end_mb_y >= s->start_mb_y)
         ff_mpeg_draw_horiz_band(s, (s->end_mb_y - 1) * 16, 16);
+    vc1_report_decode_progress(v, s->end_mb_y - 1);
     ff_er_add_slice(&s->er, 0, s->start_mb_y << v->field_mode, s->mb_width - 1,
                     (s->end_mb_y << v->field_mode) - 1, ER_MB_END);
 }
@@ -5109,6 +5158,7 @@ static void vc1_decode_b_blocks(VC1Context *v)
     for (s->mb_y = s->start_mb_y; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x = 0;
         init_block_index(v);
+        vc1_await_references(v);
         for (; s->mb_x < s->mb_width; s->mb_x++) {
             ff_update_block_index(s);
 
@@ -5149,6 +5199,7 @@ static void vc1_decode_skip_blocks(VC1Context *v)
         s->mb_x = 0;
         init_block_index(v);
         ff_update_block_index(s);
+        vc1_await_references(v);
         if (s->last_picture.f.data[0]) {
             memcpy(s->dest[0], s->last_picture.f.data[0] + s->mb_y * 16 * s->linesize,   s->linesize   * 16);
             memcpy(s->dest[1], s->last_picture.f.data[1] + s->mb_y *  8 * s->uvlinesize, s->uvlinesize *  8);
@@ -5156,6 +5207,7 @@ static void vc1_decode_skip_blocks(VC1Context *v)
         }
         ff_mpeg_draw_horiz_band(s, s->mb_y * 16, 16);
         s->first_slice_line = 0;
+        vc1_report_decode_progress(v, s->mb_y);
     }
     s->pict_type = AV_PICTURE_TYPE_P;
 }
@@ -5469,6 +5521,71 @@ static void vc1_sprite_flush(AVCodecContext *avctx)
 
 #endif
 
+/* per MB row state, private to each context decoding a slice */
+static av_cold int vc1_alloc_row_buffers(VC1Context *v, const MpegEncContext *s)
+{
+    v->block         = av_malloc(sizeof(*v->block) * v->n_allocated_blks);
+    v->cbp_base      = av_malloc(sizeof(v->cbp_base[0]) * 2 * s->mb_stride);
+    v->cbp           = v->cbp_base + s->mb_stride;
+    v->ttblk_base    = av_malloc(sizeof(v->ttblk_base[0]) * 2 * s->mb_stride);
+    v->ttblk         = v->ttblk_base + s->mb_stride;
+    v->is_intra_base = av_mallocz(sizeof(v->is_intra_base[0]) * 2 * s->mb_stride);
+    v->is_intra      = v->is_intra_base + s->mb_stride;
+    v->luma_mv_base  = av_malloc(sizeof(v->luma_mv_base[0]) * 2 * s->mb_stride);
+    v->luma_mv       = v->luma_mv_base + s->mb_stride;
+
+    if (!v->block || !v->cbp_base || !v->ttblk_base || !v->is_intra_base ||
+        !v->luma_mv_base)
+        return AVERROR(ENOMEM);
+    return 0;
+}
+
+static void vc1_free_row_buffers(VC1Context *v)
+{
+    av_freep(&v->block);
+    av_freep(&v->cbp_base);
+    av_freep(&v->ttblk_base);
+    av_freep(&v->is_intra_base); // FIXME use v->mb_type[]
+    av_freep(&v->luma_mv_base);
+}
+
+/** Allocate one context per slice thread, with its own MB row buffers.
+ *  The MpegEncContext scratch buffers come from s->thread_context[].
+ */
+static av_cold int vc1_alloc_slice_contexts(VC1Context *v)
+{
+    MpegEncContext *s = &v->s;
+    int i;
+
+    v->slice_ctx = av_mallocz((s->slice_context_count + 1) * sizeof(*v->slice_ctx));
+    if (!v->slice_ctx)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < s->slice_context_count; i++) {
+        VC1Context *sv = av_mallocz(sizeof(*sv));
+        if (!sv)
+            return AVERROR(ENOMEM);
+        v->slice_ctx[i]      = sv;
+        sv->n_allocated_blks = v->n_allocated_blks;
+        if (vc1_alloc_row_buffers(sv, s) < 0)
+            return AVERROR(ENOMEM);
+    }
+    return 0;
+}
+
+static void vc1_free_slice_contexts(VC1Context *v)
+{
+    int i;
+
+    if (!v->slice_ctx)
+        return;
+    for (i = 0; v->slice_ctx[i]; i++) {
+        vc1_free_row_buffers(v->slice_ctx[i]);
+        av_freep(&v->slice_ctx[i]);
+    }
+    av_freep(&v->slice_ctx);
+}
+
 av_cold int ff_vc1_decode_init_alloc_tables(VC1Context *v)
 {
     MpegEncContext *s = &v->s;
@@ -5483,15 +5600,8 @@ av_cold int ff_vc1_decode_init_alloc_tables(VC1Context *v)
     v->over_flags_plane = av_malloc (s->mb_stride * s->mb_height);
 
     v->n_allocated_blks = s->mb_width + 2;
-    v->block            = av_malloc(sizeof(*v->block) * v->n_allocated_blks);
-    v->cbp_base         = av_malloc(sizeof(v->cbp_base[0]) * 2 * s->mb_stride);
-    v->cbp              = v->cbp_base + s->mb_stride;
-    v->ttblk_base       = av_malloc(sizeof(v->ttblk_base[0]) * 2 * s->mb_stride);
-    v->ttblk            = v->ttblk_base + s->mb_stride;
-    v->is_intra_base    = av_mallocz(sizeof(v->is_intra_base[0]) * 2 * s->mb_stride);
-    v->is_intra         = v->is_intra_base + s->mb_stride;
-    v->luma_mv_base     = av_malloc(sizeof(v->luma_mv_base[0]) * 2 * s->mb_stride);
-    v->luma_mv          = v->luma_mv_base + s->mb_stride;
+    if (vc1_alloc_row_buffers(v, s) < 0)
+        return -1;
 
     /* allocate block type info in that way so it could be used with s->block_index[] */
     v->mb_type_base = av_malloc(s->b8_stride * (s->mb_height * 2 + 1) + s->mb_stride * (s->mb_height + 1) * 2);
@@ -5525,10 +5635,13 @@ av_cold int ff_vc1_decode_init_alloc_tables(VC1Context *v)
     }
 
     if (!v->mv_type_mb_plane || !v->direct_mb_plane || !v->acpred_plane || !v->over_flags_plane ||
-        !v->block || !v->cbp_base || !v->ttblk_base || !v->is_intra_base || !v->luma_mv_base ||
         !v->mb_type_base)
             return -1;
 
+    if (HAVE_THREADS && s->avctx->active_thread_type & FF_THREAD_SLICE &&
+        s->slice_context_count > 1 && vc1_alloc_slice_contexts(v) < 0)
+        return -1;
+
     return 0;
 }
 
@@ -5693,6 +5806,24 @@ static av_cold int vc1_decode_init(AVCodecContext *avctx)
     return 0;
 }
 
+/* free what ff_vc1_decode_init_alloc_tables() allocated */
+static void vc1_free_tables(VC1Context *v)
+{
+    av_freep(&v->mv_type_mb_plane);
+    av_freep(&v->direct_mb_plane);
+    av_freep(&v->forward_mb_plane);
+    av_freep(&v->fieldtx_plane);
+    av_freep(&v->acpred_plane);
+    av_freep(&v->over_flags_plane);
+    av_freep(&v->mb_type_base);
+    av_freep(&v->blk_mv_type_base);
+    av_freep(&v->mv_f_base);
+    av_freep(&v->mv_f_next_base);
+    vc1_free_row_buffers(v);
+    vc1_free_slice_contexts(v);
+    ff_intrax8_common_end(&v->x8);
+}
+
 /** Close a VC1/WMV3 decoder
  * @warning Initial try at using MpegEncContext stuff
  */
@@ -5708,22 +5839,159 @@ av_cold int ff_vc1_decode_end(AVCodecContext *avctx)
     av_freep(&v->hrd_rate);
     av_freep(&v->hrd_buffer);
     ff_MPV_common_end(&v->s);
-    av_freep(&v->mv_type_mb_plane);
-    av_freep(&v->direct_mb_plane);
-    av_freep(&v->forward_mb_plane);
-    av_freep(&v->fieldtx_plane);
-    av_freep(&v->acpred_plane);
-    av_freep(&v->over_flags_plane);
-    av_freep(&v->mb_type_base);
-    av_freep(&v->blk_mv_type_base);
-    av_freep(&v->mv_f_base);
-    av_freep(&v->mv_f_next_base);
-    av_freep(&v->block);
-    av_freep(&v->cbp_base);
-    av_freep(&v->ttblk_base);
-    av_freep(&v->is_intra_base); // FIXME use v->mb_type[]
-    av_freep(&v->luma_mv_base);
-    ff_intrax8_common_end(&v->x8);
+    vc1_free_tables(v);
+    return 0;
+}
+
+static int vc1_update_thread_context(AVCodecContext *dst, const AVCodecContext *src)
+{
+    VC1Context *v = dst->priv_data, *v1 = src->priv_data;
+    MpegEncContext *s = &v->s;
+    const MpegEncContext *s1 = &v1->s;
+    int need_alloc, plane_size, i, ret;
+
+    if (dst == src)
+        return 0;
+
+    need_alloc = !s->context_initialized ||
+                 s->width != s1->width || s->height != s1->height;
+
+    if ((ret = ff_mpeg_update_thread_context(dst, src)) < 0)
+        return ret;
+
+    if (!s1->context_initialized)
+        return 0;
+
+    if (need_alloc) {
+        vc1_free_tables(v);
+        if (ff_vc1_decode_init_alloc_tables(v) < 0)
+            return AVERROR(ENOMEM);
+    }
+
+    /* sequence header and entry point */
+    memcpy(&v->res_sprite, &v1->res_sprite,
+           (char *)&v1->finterpflag + sizeof(v1->finterpflag) - (char *)&v1->res_sprite);
+    v->hrd_num_leaky_buckets = v1->hrd_num_leaky_buckets;
+    v->range_mapy_flag       = v1->range_mapy_flag;
+    v->range_mapuv_flag      = v1->range_mapuv_flag;
+    v->range_mapy            = v1->range_mapy;
+    v->range_mapuv           = v1->range_mapuv;
+    v->broken_link           = v1->broken_link;
+    v->closed_entry          = v1->closed_entry;
+    s->loop_filter           = s1->loop_filter;
+    s->h_edge_pos            = s1->h_edge_pos;
+    s->v_edge_pos            = s1->v_edge_pos;
+
+    /* state carried over from the previous pictures */
+    memcpy(v->last_luty, v1->last_luty,
+           (char *)&v1->next_lutuv[2] - (char *)v1->last_luty);
+    v->last_use_ic    = v1->last_use_ic;
+    v->next_use_ic    = v1->next_use_ic;
+    v->aux_use_ic     = v1->aux_use_ic;
+    v->rnd            = v1->rnd;
+    v->mvrange        = v1->mvrange;
+    v->respic         = v1->respic;
+    v->qs_last        = v1->qs_last;
+    s->quarter_sample = s1->quarter_sample;
+    s->mspel          = s1->mspel;
+
+    /* field MV flags of the next anchor, used by interlaced B-fields */
+    plane_size = s->b8_stride * (s->mb_height * 2 + 1) + s->mb_stride * (s->mb_height + 1) * 2;
+    if (v->mv_f_next_base && v1->mv_f_next_base)
+        for (i = 0; i < 2; i++)
+            memcpy(v->mv_f_next[i] - s->b8_stride - 1,
+                   v1->mv_f_next[i] - s1->b8_stride - 1, plane_size);
+
+    return 0;
+}
+
+typedef struct VC1SliceJob {
+    GetBitContext gb;
+    int start_mb_y, end_mb_y;
+    int error_count, error_occurred;
+} VC1SliceJob;
+
+/** Set up the slice context of a thread from the main context, keeping
+ *  its own MB row buffers and MpegEncContext scratch buffers.
+ */
+static int vc1_update_slice_context(VC1Context *sv, VC1Context *v, int threadnr)
+{
+    MpegEncContext *s   = &v->s;
+    MpegEncContext *dup = s->thread_context[threadnr];
+    int16_t (*block)[6][64]    = sv->block;
+    uint32_t *cbp_base         = sv->cbp_base;
+    int *ttblk_base            = sv->ttblk_base;
+    uint8_t *is_intra_base     = sv->is_intra_base;
+    int16_t (*luma_mv_base)[2] = sv->luma_mv_base;
+    int ret;
+
+    if (dup != s && (ret = ff_update_duplicate_context(dup, s)) < 0)
+        return ret;
+
+    memcpy(sv, v, sizeof(*sv));
+    sv->s             = *dup;
+    sv->block         = block;
+    sv->cbp_base      = cbp_base;
+    sv->cbp           = cbp_base + s->mb_stride;
+    sv->ttblk_base    = ttblk_base;
+    sv->ttblk         = ttblk_base + s->mb_stride;
+    sv->is_intra_base = is_intra_base;
+    sv->is_intra      = is_intra_base + s->mb_stride;
+    sv->luma_mv_base  = luma_mv_base;
+    sv->luma_mv       = luma_mv_base + s->mb_stride;
+    return 0;
+}
+
+static int vc1_decode_slice_thread(AVCodecContext *avctx, void *arg,
+                                   int jobnr, int threadnr)
+{
+    VC1Context *v    = avctx->priv_data;
+    VC1Context *sv   = v->slice_ctx[threadnr];
+    VC1SliceJob *job = (VC1SliceJob *)arg + jobnr;
+    int ret;
+
+    if ((ret = vc1_update_slice_context(sv, v, threadnr)) < 0)
+        return ret;
+
+    sv->s.gb         = job->gb;
+    sv->s.start_mb_y = job->start_mb_y;
+    sv->s.end_mb_y   = job->end_mb_y;
+    ff_vc1_decode_blocks(sv);
+
+    job->error_count    = sv->s.er.error_count;
+    job->error_occurred = sv->s.er.error_occurred;
+    return 0;
+}
+
+/** Decode the slices of a progressive picture in parallel.
+ *  Slices do not predict from each other and the filters stop at slice
+ *  boundaries, so this only requires that no slice carries a picture header.
+ */
+static int vc1_decode_slices(AVCodecContext *avctx, VC1SliceJob *jobs, int nb_jobs)
+{
+    VC1Context *v     = avctx->priv_data;
+    MpegEncContext *s = &v->s;
+    int error_count   = s->er.error_count;
+    int i, ret;
+
+    if (!nb_jobs)
+        return 0;
+
+    for (i = 0; i < nb_jobs; i++) {
+        jobs[i].error_count    = error_count;
+        jobs[i].error_occurred = 0;
+    }
+    if ((ret = avctx->execute2(avctx, vc1_decode_slice_thread, jobs, NULL, nb_jobs)) < 0)
+        return ret;
+
+    for (i = 0; i < nb_jobs; i++) {
+        if (jobs[i].error_occurred)
+            s->er.error_occurred = 1;
+        if (jobs[i].error_count == INT_MAX || s->er.error_count == INT_MAX)
+            s->er.error_count = INT_MAX;
+        else
+            s->er.error_count -= error_count - jobs[i].error_count;
+    }
     return 0;
 }
 
@@ -5741,7 +6009,7 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     AVFrame *pict = data;
     uint8_t *buf2 = NULL;
     const uint8_t *buf_start = buf, *buf_start_second_field = NULL;
-    int mb_height, n_slices1=-1;
+    int mb_height, n_slices1=-1, slice_headers = 0;
     struct {
         uint8_t *buf;
         GetBitContext gb;
@@ -6040,8 +6308,22 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
                 goto err;
         }
     } else {
-        int header_ret = 0;
-
+        VC1SliceJob *jobs = NULL;
+        int header_ret = 0, nb_jobs = 0;
+
+        /* The next frame thread only needs the picture header state, which
+         * is final here for progressive pictures without slice headers.
+         * Interlaced pictures also pass on state built while decoding the
+         * fields, so they finish the setup after decoding and wait for whole
+         * reference pictures instead of rows. */
+        if (!v->field_mode)
+            for (i = 0; i < n_slices; i++)
+                slice_headers |= show_bits1(&slices[i].gb);
+        if (v->fcm == PROGRESSIVE) {
+            if (!slice_headers)
+                ff_thread_finish_setup(avctx);
+        } else
+            vc1_await_references(v);
 
         ff_mpeg_er_frame_start(s);
 
@@ -6055,6 +6337,14 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
             s->uvlinesize                    <<= 1;
         }
         mb_height = s->mb_height >> v->field_mode;
+        /* slices are queued and decoded in parallel after the loop */
+        if (HAVE_THREADS && avctx->active_thread_type & FF_THREAD_SLICE &&
+            v->slice_ctx && s->slice_context_count >= avctx->thread_count &&
+            v->fcm == PROGRESSIVE && !slice_headers && n_slices) {
+            jobs = av_malloc((n_slices + 1) * sizeof(*jobs));
+            if (!jobs)
+                goto err;
+        }
         for (i = 0; i <= n_slices; i++) {
             if (i > 0 &&  slices[i - 1].mby_start >= mb_height) {
                 if (v->field_mode <= 0) {
@@ -6106,10 +6396,22 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
                 av_log(v->s.avctx, AV_LOG_ERROR, "missing cbpcy_vlc\n");
                 continue;
             }
-            ff_vc1_decode_blocks(v);
+            if (jobs) {
+                jobs[nb_jobs].gb         = s->gb;
+                jobs[nb_jobs].start_mb_y = s->start_mb_y;
+                jobs[nb_jobs].end_mb_y   = s->end_mb_y;
+                nb_jobs++;
+            } else
+                ff_vc1_decode_blocks(v);
             if (i != n_slices)
                 s->gb = slices[i].gb;
         }
+        if (jobs) {
+            ret = vc1_decode_slices(avctx, jobs, nb_jobs);
+            av_freep(&jobs);
+            if (ret < 0)
+                goto err;
+        }
         if (v->field_mode) {
             v->second_field = 0;
             s->current_picture.f.linesize[0] >>= 1;
@@ -6209,10 +6511,12 @@ AVCodec ff_vc1_decoder = {
     .close          = ff_vc1_decode_end,
     .decode         = vc1_decode_frame,
     .flush          = ff_mpeg_flush,
-    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_DELAY,
+    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_DELAY |
+                      CODEC_CAP_FRAME_THREADS | CODEC_CAP_SLICE_THREADS,
     .long_name      = NULL_IF_CONFIG_SMALL("SMPTE VC-1"),
     .pix_fmts       = vc1_hwaccel_pixfmt_list_420,
-    .profiles       = NULL_IF_CONFIG_SMALL(profiles)
+    .profiles       = NULL_IF_CONFIG_SMALL(profiles),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vc1_update_thread_context),
 };
 
 #if CONFIG_WMV3_DECODER
@@ -6225,10 +6529,12 @@ AVCodec ff_wmv3_decoder = {
     .close          = ff_vc1_decode_end,
     .decode         = vc1_decode_frame,
     .flush          = ff_mpeg_flush,
-    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_DELAY,
+    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_DELAY |
+                      CODEC_CAP_FRAME_THREADS | CODEC_CAP_SLICE_THREADS,
     .long_name      = NULL_IF_CONFIG_SMALL("Windows Media Video 9"),
     .pix_fmts       = vc1_hwaccel_pixfmt_list_420,
-    .profiles       = NULL_IF_CONFIG_SMALL(profiles)
+    .profiles       = NULL_IF_CONFIG_SMALL(profiles),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vc1_update_thread_context),
 };
 #endif
 
@@ -195,6 +195,8 @@ static av_cold void volume_init(VolumeContext *vol)
         break;
     }
 
+    if (ARCH_ARM)
+        ff_volume_init_arm(vol);
     if (ARCH_X86)
         ff_volume_init_x86(vol);
 }
@@ -24,19 +24,39 @@
  * internal API functions
  */
 
+#include "libavutil/buffer.h"
 #include "avfilter.h"
 #include "avfiltergraph.h"
 #include "formats.h"
+#include "thread.h"
 #include "video.h"
 
-#define POOL_SIZE 32
+/**
+ * Pool of video frame buffers attached to a link, reused as long as the
+ * format and the dimensions of the requested frames do not change.
+ */
 typedef struct AVFilterPool {
-    AVFilterBufferRef *pic[POOL_SIZE];
-    int count;
-    int refcount;
-    int draining;
+    int width;
+    int height;
+    int format;
+    int linesize[4];
+    AVBufferPool *pools[4];
 } AVFilterPool;
 
+/**
+ * Free the video frame pool of a link. Frames allocated from it stay valid.
+ */
+void ff_video_frame_pool_uninit(AVFilterPool **pool);
+
+struct AVFilterGraphInternal {
+    void *thread;
+    avfilter_execute_func *thread_execute;
+};
+
+struct AVFilterInternal {
+    avfilter_execute_func *execute;
+};
+
 typedef struct AVFilterCommand {
     double time;                ///< time expressed in seconds
     char *command;              ///< command
@@ -354,4 +374,27 @@ AVFilterContext *ff_filter_alloc(const AVFilter *filter, const char *inst_name);
  */
 void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter);
 
+/**
+ * Run func nb_jobs times, possibly in parallel on the graph thread pool
+ * if the filter has slice threading enabled.
+ *
+ * @return 0 on success, a negative AVERROR on error
+ */
+static inline int ff_filter_execute(AVFilterContext *ctx, avfilter_action_func *func,
+                                    void *arg, int *ret, int nb_jobs)
+{
+    return ctx->internal->execute(ctx, func, arg, ret, nb_jobs);
+}
+
+/**
+ * Get the number of threads available to a slice-threaded filter, i.e. the
+ * number of jobs it should split its work into; 1 if threading is not used.
+ */
+static inline int ff_filter_get_nb_threads(AVFilterContext *ctx)
+{
+    if (ctx->thread_type & AVFILTER_THREAD_SLICE)
+        return FFMAX(ctx->graph->nb_threads, 1);
+    return 1;
+}
+
 #endif /* AVFILTER_INTERNAL_H */
@@ -0,0 +1,112 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Libavfilter multithreading support
+ */
+
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "libavutil/slicethread.h"
+
+#include "avfilter.h"
+#include "internal.h"
+#include "thread.h"
+
+typedef struct ThreadContext {
+    AVSliceThread *thread;
+    avfilter_action_func *func;
+
+    /* per-execute parameters */
+    AVFilterContext *ctx;
+    void *arg;
+    int   *rets;
+    int nb_rets;
+} ThreadContext;
+
+static void worker_func(void *priv, int jobnr, int threadnr,
+                        int nb_jobs, int nb_threads)
+{
+    ThreadContext *c = priv;
+
+    c->rets[jobnr % c->nb_rets] = c->func(c->ctx, c->arg, jobnr, nb_jobs);
+}
+
+static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
+                          void *arg, int *ret, int nb_jobs)
+{
+    ThreadContext *c = ctx->graph->internal->thread;
+    int dummy_ret;
+
+    if (nb_jobs <= 0)
+        return 0;
+
+    c->ctx         = ctx;
+    c->arg         = arg;
+    c->func        = func;
+    if (ret) {
+        c->rets    = ret;
+        c->nb_rets = nb_jobs;
+    } else {
+        c->rets    = &dummy_ret;
+        c->nb_rets = 1;
+    }
+
+    avpriv_slicethread_execute(c->thread, nb_jobs);
+
+    return 0;
+}
+
+int ff_graph_thread_init(AVFilterGraph *graph)
+{
+    ThreadContext *c;
+    int ret;
+
+    if (graph->nb_threads == 1) {
+        graph->thread_type = 0;
+        return 0;
+    }
+
+    graph->internal->thread = c = av_mallocz(sizeof(ThreadContext));
+    if (!c)
+        return AVERROR(ENOMEM);
+
+    ret = avpriv_slicethread_create(&c->thread, c, worker_func,
+                                    graph->nb_threads);
+    if (ret <= 1) {
+        av_freep(&graph->internal->thread);
+        graph->thread_type = 0;
+        graph->nb_threads  = 1;
+        return (ret < 0 && ret != AVERROR(ENOSYS)) ? ret : 0;
+    }
+    graph->nb_threads = ret;
+
+    graph->internal->thread_execute = thread_execute;
+
+    return 0;
+}
+
+void ff_graph_thread_free(AVFilterGraph *graph)
+{
+    ThreadContext *c = graph->internal->thread;
+
+    if (c)
+        avpriv_slicethread_free(&c->thread);
+    av_freep(&graph->internal->thread);
+}
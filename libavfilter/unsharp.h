@@ -55,7 +55,7 @@ typedef struct UnsharpFilterParam {
     int steps_y;                             ///< vertical step count
     int scalebits;                           ///< bits to shift pixel
     int32_t halfscale;                       ///< amount to add to pixel
-    uint32_t *sc[MAX_MATRIX_SIZE - 1];       ///< finite state machine storage
+    uint32_t *sc[2][MAX_MATRIX_SIZE - 1];    ///< finite state machine storage, one set per plane
 } UnsharpFilterParam;
 
 typedef struct {
@@ -70,7 +70,8 @@ typedef struct {
     int hsub, vsub;
     int radius[4];
     int power[4];
-    uint8_t *temp[2]; ///< temporary buffer used in blur_power()
+    uint8_t **temp;   ///< temporary buffers used in blur_power(), two per job
+    int nb_jobs;      ///< maximum number of concurrent jobs, size of temp / 2
 } BoxBlurContext;
 
 #define Y 0
@@ -110,9 +111,13 @@ static av_cold int init(AVFilterContext *ctx)
 static av_cold void uninit(AVFilterContext *ctx)
 {
     BoxBlurContext *s = ctx->priv;
+    int i;
 
-    av_freep(&s->temp[0]);
-    av_freep(&s->temp[1]);
+    if (s->temp)
+        for (i = 0; i < 2 * s->nb_jobs; i++)
+            av_freep(&s->temp[i]);
+    av_freep(&s->temp);
+    s->nb_jobs = 0;
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -139,11 +144,16 @@ static int config_input(AVFilterLink *inlink)
     int cw, ch;
     double var_values[VARS_NB], res;
     char *expr;
-    int ret;
+    int i, ret;
 
-    if (!(s->temp[0] = av_malloc(FFMAX(w, h))) ||
-        !(s->temp[1] = av_malloc(FFMAX(w, h))))
+    uninit(ctx);
+
+    s->nb_jobs = ff_filter_get_nb_threads(ctx);
+    if (!(s->temp = av_mallocz(2 * s->nb_jobs * sizeof(*s->temp))))
         return AVERROR(ENOMEM);
+    for (i = 0; i < 2 * s->nb_jobs; i++)
+        if (!(s->temp[i] = av_malloc(FFMAX(w, h))))
+            return AVERROR(ENOMEM);
 
     s->hsub = desc->log2_chroma_w;
     s->vsub = desc->log2_chroma_h;
@@ -295,12 +305,49 @@ static void vblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_li
                    h, radius, power, temp);
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int plane;
+    int w, h;
+} ThreadData;
+
+static int hblur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    int p = td->plane;
+    int slice_start = (td->h *  jobnr   ) / nb_jobs;
+    int slice_end   = (td->h * (jobnr+1)) / nb_jobs;
+
+    hblur(td->out->data[p] + slice_start * td->out->linesize[p], td->out->linesize[p],
+          td->in ->data[p] + slice_start * td->in ->linesize[p], td->in ->linesize[p],
+          td->w, slice_end - slice_start, s->radius[p], s->power[p],
+          &s->temp[2 * jobnr]);
+    return 0;
+}
+
+static int vblur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    int p = td->plane;
+    int slice_start = (td->w *  jobnr   ) / nb_jobs;
+    int slice_end   = (td->w * (jobnr+1)) / nb_jobs;
+
+    vblur(td->out->data[p] + slice_start, td->out->linesize[p],
+          td->out->data[p] + slice_start, td->out->linesize[p],
+          slice_end - slice_start, td->h, s->radius[p], s->power[p],
+          &s->temp[2 * jobnr]);
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
     BoxBlurContext *s = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
     AVFrame *out;
+    ThreadData td;
     int plane;
     int cw = FF_CEIL_RSHIFT(inlink->w, s->hsub), ch = FF_CEIL_RSHIFT(in->height, s->vsub);
     int w[4] = { inlink->w, cw, cw, inlink->w };
@@ -313,17 +360,23 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     }
     av_frame_copy_props(out, in);
 
-    for (plane = 0; in->data[plane] && plane < 4; plane++)
-        hblur(out->data[plane], out->linesize[plane],
-              in ->data[plane], in ->linesize[plane],
-              w[plane], h[plane], s->radius[plane], s->power[plane],
-              s->temp);
+    td.in  = in;
+    td.out = out;
+
+    /* rows are independent in the horizontal pass, columns in the vertical one */
+    for (plane = 0; in->data[plane] && plane < 4; plane++) {
+        td.plane = plane;
+        td.w     = w[plane];
+        td.h     = h[plane];
+        ff_filter_execute(ctx, hblur_slice, &td, NULL, FFMIN(h[plane], s->nb_jobs));
+    }
 
-    for (plane = 0; in->data[plane] && plane < 4; plane++)
-        vblur(out->data[plane], out->linesize[plane],
-              out->data[plane], out->linesize[plane],
-              w[plane], h[plane], s->radius[plane], s->power[plane],
-              s->temp);
+    for (plane = 0; in->data[plane] && plane < 4; plane++) {
+        td.plane = plane;
+        td.w     = w[plane];
+        td.h     = h[plane];
+        ff_filter_execute(ctx, vblur_slice, &td, NULL, FFMIN(w[plane], s->nb_jobs));
+    }
 
     av_frame_free(&in);
 
@@ -383,5 +436,5 @@ AVFilter avfilter_vf_boxblur = {
 
     .inputs    = avfilter_vf_boxblur_inputs,
     .outputs   = avfilter_vf_boxblur_outputs,
-    .flags     = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags     = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -279,6 +279,11 @@ static int config_props(AVFilterLink *outlink)
                                         scale->flags, NULL, NULL, NULL);
         if (!scale->sws || !scale->isws[0] || !scale->isws[1])
             return AVERROR(EINVAL);
+
+        /* the scaling itself is threaded by libswscale */
+        av_opt_set_int(scale->sws,     "threads", ff_filter_get_nb_threads(ctx), 0);
+        av_opt_set_int(scale->isws[0], "threads", ff_filter_get_nb_threads(ctx), 0);
+        av_opt_set_int(scale->isws[1], "threads", ff_filter_get_nb_threads(ctx), 0);
     }
 
     if (inlink->sample_aspect_ratio.num){
@@ -435,4 +440,5 @@ AVFilter avfilter_vf_scale = {
 
     .inputs    = avfilter_vf_scale_inputs,
     .outputs   = avfilter_vf_scale_outputs,
+    .flags     = AVFILTER_FLAG_SLICE_THREADS,
 };
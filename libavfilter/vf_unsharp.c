@@ -50,9 +50,9 @@
 
 static void apply_unsharp(      uint8_t *dst, int dst_stride,
                           const uint8_t *src, int src_stride,
-                          int width, int height, UnsharpFilterParam *fp)
+                          int width, int height, UnsharpFilterParam *fp,
+                          uint32_t **sc)
 {
-    uint32_t **sc = fp->sc;
     uint32_t sr[MAX_MATRIX_SIZE - 1], tmp1, tmp2;
 
     int32_t res;
@@ -102,24 +102,33 @@ static void apply_unsharp(      uint8_t *dst, int dst_stride,
     }
 }
 
-static int apply_unsharp_c(AVFilterContext *ctx, AVFrame *in, AVFrame *out)
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
+static int unsharp_plane(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     AVFilterLink *inlink = ctx->inputs[0];
     UnsharpContext *unsharp = ctx->priv;
-    int i, plane_w[3], plane_h[3];
-    UnsharpFilterParam *fp[3];
-    plane_w[0] = inlink->w;
-    plane_w[1] = plane_w[2] = FF_CEIL_RSHIFT(inlink->w, unsharp->hsub);
-    plane_h[0] = inlink->h;
-    plane_h[1] = plane_h[2] = FF_CEIL_RSHIFT(inlink->h, unsharp->vsub);
-    fp[0] = &unsharp->luma;
-    fp[1] = fp[2] = &unsharp->chroma;
-    for (i = 0; i < 3; i++) {
-        apply_unsharp(out->data[i], out->linesize[i], in->data[i], in->linesize[i], plane_w[i], plane_h[i], fp[i]);
-    }
+    ThreadData *td = arg;
+    UnsharpFilterParam *fp = jobnr ? &unsharp->chroma : &unsharp->luma;
+    int w = jobnr ? FF_CEIL_RSHIFT(inlink->w, unsharp->hsub) : inlink->w;
+    int h = jobnr ? FF_CEIL_RSHIFT(inlink->h, unsharp->vsub) : inlink->h;
+
+    /* the chroma planes each get their own state so they can run concurrently */
+    apply_unsharp(td->out->data[jobnr], td->out->linesize[jobnr],
+                  td->in->data[jobnr],  td->in->linesize[jobnr],
+                  w, h, fp, fp->sc[jobnr == 2]);
     return 0;
 }
 
+static int apply_unsharp_c(AVFilterContext *ctx, AVFrame *in, AVFrame *out)
+{
+    ThreadData td = { .in = in, .out = out };
+
+    return ff_filter_execute(ctx, unsharp_plane, &td, NULL, 3);
+}
+
 static void set_filter_param(UnsharpFilterParam *fp, int msize_x, int msize_y, float amount)
 {
     fp->msize_x = msize_x;
@@ -168,9 +177,10 @@ static int query_formats(AVFilterContext *ctx)
     return 0;
 }
 
-static int init_filter_param(AVFilterContext *ctx, UnsharpFilterParam *fp, const char *effect_type, int width)
+static int init_filter_param(AVFilterContext *ctx, UnsharpFilterParam *fp, const char *effect_type,
+                             int width, int nb_planes)
 {
-    int z;
+    int p, z;
     const char *effect = fp->amount == 0 ? "none" : fp->amount < 0 ? "blur" : "sharpen";
 
     if  (!(fp->msize_x & fp->msize_y & 1)) {
@@ -183,9 +193,10 @@ static int init_filter_param(AVFilterContext *ctx, UnsharpFilterParam *fp, const
     av_log(ctx, AV_LOG_VERBOSE, "effect:%s type:%s msize_x:%d msize_y:%d amount:%0.2f\n",
            effect, effect_type, fp->msize_x, fp->msize_y, fp->amount / 65535.0);
 
-    for (z = 0; z < 2 * fp->steps_y; z++)
-        if (!(fp->sc[z] = av_malloc(sizeof(*(fp->sc[z])) * (width + 2 * fp->steps_x))))
-            return AVERROR(ENOMEM);
+    for (p = 0; p < nb_planes; p++)
+        for (z = 0; z < 2 * fp->steps_y; z++)
+            if (!(fp->sc[p][z] = av_malloc(sizeof(*(fp->sc[p][z])) * (width + 2 * fp->steps_x))))
+                return AVERROR(ENOMEM);
 
     return 0;
 }
@@ -199,10 +210,10 @@ static int config_props(AVFilterLink *link)
     unsharp->hsub = desc->log2_chroma_w;
     unsharp->vsub = desc->log2_chroma_h;
 
-    ret = init_filter_param(link->dst, &unsharp->luma,   "luma",   link->w);
+    ret = init_filter_param(link->dst, &unsharp->luma,   "luma",   link->w, 1);
     if (ret < 0)
         return ret;
-    ret = init_filter_param(link->dst, &unsharp->chroma, "chroma", FF_CEIL_RSHIFT(link->w, unsharp->hsub));
+    ret = init_filter_param(link->dst, &unsharp->chroma, "chroma", FF_CEIL_RSHIFT(link->w, unsharp->hsub), 2);
     if (ret < 0)
         return ret;
 
@@ -211,10 +222,11 @@ static int config_props(AVFilterLink *link)
 
 static void free_filter_param(UnsharpFilterParam *fp)
 {
-    int z;
+    int p, z;
 
-    for (z = 0; z < 2 * fp->steps_y; z++)
-        av_free(fp->sc[z]);
+    for (p = 0; p < 2; p++)
+        for (z = 0; z < 2 * fp->steps_y; z++)
+            av_free(fp->sc[p][z]);
 }
 
 static av_cold void uninit(AVFilterContext *ctx)
@@ -311,5 +323,5 @@ AVFilter avfilter_vf_unsharp = {
 
     .inputs    = avfilter_vf_unsharp_inputs,
     .outputs   = avfilter_vf_unsharp_outputs,
-    .flags     = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags     = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
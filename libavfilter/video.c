@@ -27,6 +27,7 @@
 #include "libavutil/buffer.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
 
 #include "avfilter.h"
 #include "internal.h"
@@ -37,40 +38,80 @@ AVFrame *ff_null_get_video_buffer(AVFilterLink *link, int w, int h)
     return ff_get_video_buffer(link->dst->outputs[0], w, h);
 }
 
-/* TODO: set the buffer's priv member to a context structure for the whole
- * filter chain.  This will allow for a buffer pool instead of the constant
- * alloc & free cycle currently implemented. */
-AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
+void ff_video_frame_pool_uninit(AVFilterPool **pool)
+{
+    int i;
+
+    if (!*pool)
+        return;
+
+    for (i = 0; i < 4; i++)
+        av_buffer_pool_uninit(&(*pool)->pools[i]);
+    av_freep(pool);
+}
+
+static AVFilterPool *video_frame_pool_init(int w, int h, int format)
 {
-    AVFrame *frame = av_frame_alloc();
-    int ret;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+    AVFilterPool *pool;
+    int i;
+
+    if (!desc || av_image_check_size(w, h, 0, NULL) < 0)
+        return NULL;
+
+    pool = av_mallocz(sizeof(*pool));
+    if (!pool)
+        return NULL;
+
+    pool->width  = w;
+    pool->height = h;
+    pool->format = format;
+
+    /* same layout as av_frame_get_buffer() with an alignment of 32 */
+    if (av_image_fill_linesizes(pool->linesize, format, w) < 0)
+        goto fail;
+
+    for (i = 0; i < 4 && pool->linesize[i]; i++) {
+        int plane_h = FFALIGN(h, 32);
+        int size;
+
+        pool->linesize[i] = FFALIGN(pool->linesize[i], 32);
+        if (i == 1 || i == 2)
+            plane_h = FF_CEIL_RSHIFT(plane_h, desc->log2_chroma_h);
+        size = pool->linesize[i] * plane_h + 16;
+
+        pool->pools[i] = av_buffer_pool_init(size, NULL);
+        if (!pool->pools[i])
+            goto fail;
+    }
+    if (desc->flags & AV_PIX_FMT_FLAG_PAL || desc->flags & AV_PIX_FMT_FLAG_PSEUDOPAL) {
+        av_buffer_pool_uninit(&pool->pools[1]);
+        pool->pools[1] = av_buffer_pool_init(1024, NULL);
+        if (!pool->pools[1])
+            goto fail;
+    }
+
+    return pool;
+fail:
+    ff_video_frame_pool_uninit(&pool);
+    return NULL;
+}
 
-#if 0 //POOL
+AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
+{
     AVFilterPool *pool = link->pool;
-    if (pool) {
-        for (i = 0; i < POOL_SIZE; i++) {
-            picref = pool->pic[i];
-            if (picref && picref->buf->format == link->format && picref->buf->w == w && picref->buf->h == h) {
-                AVFilterBuffer *pic = picref->buf;
-                pool->pic[i] = NULL;
-                pool->count--;
-                av_assert0(!picref->video->qp_table);
-                picref->video->w = w;
-                picref->video->h = h;
-                picref->perms = full_perms;
-                picref->format = link->format;
-                pic->refcount = 1;
-                memcpy(picref->data,     pic->data,     sizeof(picref->data));
-                memcpy(picref->linesize, pic->linesize, sizeof(picref->linesize));
-                pool->refcount++;
-                return picref;
-            }
-        }
-    } else {
-        pool = link->pool = av_mallocz(sizeof(AVFilterPool));
-        pool->refcount = 1;
+    AVFrame *frame;
+    int i;
+
+    if (!pool || pool->width != w || pool->height != h ||
+        pool->format != link->format) {
+        ff_video_frame_pool_uninit(&link->pool);
+        pool = link->pool = video_frame_pool_init(w, h, link->format);
+        if (!pool)
+            return NULL;
     }
-#endif
+
+    frame = av_frame_alloc();
     if (!frame)
         return NULL;
 
@@ -78,17 +119,16 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
     frame->height = h;
     frame->format = link->format;
 
-    ret = av_frame_get_buffer(frame, 32);
-    if (ret < 0)
-        av_frame_free(&frame);
-
-#if 0 //POOL
-    memset(data[0], 128, i);
-
-    picref->buf->priv = pool;
-    picref->buf->free = NULL;
-    pool->refcount++;
-#endif
+    for (i = 0; i < 4 && pool->pools[i]; i++) {
+        frame->buf[i] = av_buffer_pool_get(pool->pools[i]);
+        if (!frame->buf[i]) {
+            av_frame_free(&frame);
+            return NULL;
+        }
+        frame->data[i]     = frame->buf[i]->data;
+        frame->linesize[i] = pool->linesize[i];
+    }
+    frame->extended_data = frame->data;
 
     return frame;
 }
@@ -69,6 +69,7 @@ typedef struct YADIFContext {
     int temp_line_size;
 } YADIFContext;
 
+void ff_yadif_init_arm(YADIFContext *yadif);
 void ff_yadif_init_x86(YADIFContext *yadif);
 
 #endif /* AVFILTER_YADIF_H */
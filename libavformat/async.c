@@ -0,0 +1,308 @@
+/*
+ * Asynchronous read-ahead protocol
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Read ahead of the nested protocol from a background thread.
+ *
+ * The thread fills a ring buffer while the caller is busy demuxing and
+ * decoding. Seeks inside the buffered data are served from the buffer,
+ * other seeks are forwarded to the thread, which drops the buffer and
+ * continues reading from the new position.
+ */
+
+#include <pthread.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/fifo.h"
+#include "libavutil/opt.h"
+#include "avformat.h"
+#include "url.h"
+
+#define READ_CHUNK_SIZE 4096
+
+typedef struct Context {
+    const AVClass *class;
+    URLContext *inner;
+    int buffer_size;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond_main;       ///< signaled when data or a seek result is available
+    pthread_cond_t cond_background; ///< signaled when space or a seek request is available
+    AVFifoBuffer *fifo;
+
+    int64_t logical_pos;            ///< position of the caller in the stream
+    int64_t logical_size;
+    int eof_reached;
+    int error;                      ///< error returned by the nested protocol
+    int abort_request;
+
+    int seek_request;
+    int seek_completed;
+    int64_t seek_pos;
+    int64_t seek_ret;
+
+    /* statistics */
+    int64_t nb_reads;
+    int64_t nb_underruns;
+    int64_t fill_sum;
+} Context;
+
+static int async_check_interrupt(void *arg)
+{
+    URLContext *h = arg;
+    Context *c    = h->priv_data;
+    return c->abort_request || ff_check_interrupt(&h->interrupt_callback);
+}
+
+static void *async_buffer_task(void *arg)
+{
+    URLContext *h = arg;
+    Context *c = h->priv_data;
+    uint8_t buf[READ_CHUNK_SIZE];
+    int ret;
+
+    pthread_mutex_lock(&c->lock);
+    while (!c->abort_request) {
+        if (c->seek_request) {
+            int64_t pos = c->seek_pos;
+            int64_t seek_ret;
+
+            pthread_mutex_unlock(&c->lock);
+            seek_ret = ffurl_seek(c->inner, pos, SEEK_SET);
+            pthread_mutex_lock(&c->lock);
+
+            if (seek_ret >= 0) {
+                av_fifo_reset(c->fifo);
+                c->logical_pos = seek_ret;
+                c->eof_reached = 0;
+                c->error       = 0;
+            }
+            c->seek_ret       = seek_ret;
+            c->seek_request   = 0;
+            c->seek_completed = 1;
+            pthread_cond_signal(&c->cond_main);
+            continue;
+        }
+
+        if (c->eof_reached || av_fifo_space(c->fifo) < READ_CHUNK_SIZE) {
+            pthread_cond_wait(&c->cond_background, &c->lock);
+            continue;
+        }
+
+        pthread_mutex_unlock(&c->lock);
+        ret = ffurl_read(c->inner, buf, sizeof(buf));
+        pthread_mutex_lock(&c->lock);
+
+        /* the data read before a seek request is not wanted anymore */
+        if (c->seek_request)
+            continue;
+
+        if (ret > 0) {
+            av_fifo_generic_write(c->fifo, buf, ret, NULL);
+        } else {
+            c->eof_reached = 1;
+            c->error       = ret;
+        }
+        pthread_cond_signal(&c->cond_main);
+    }
+    pthread_mutex_unlock(&c->lock);
+
+    return NULL;
+}
+
+static int async_open(URLContext *h, const char *arg, int flags)
+{
+    Context *c = h->priv_data;
+    int ret;
+    AVIOInterruptCB interrupt_callback = {
+        .callback = async_check_interrupt,
+        .opaque   = h,
+    };
+
+    if (flags & AVIO_FLAG_WRITE)
+        return AVERROR(ENOSYS);
+
+    av_strstart(arg, "async:", &arg);
+
+    c->fifo = av_fifo_alloc(c->buffer_size);
+    if (!c->fifo)
+        return AVERROR(ENOMEM);
+
+    /* the background thread must notice abort_request while it is blocked
+     * in the nested protocol, so chain it in front of the user callback */
+    ret = ffurl_open(&c->inner, arg, flags, &interrupt_callback, NULL);
+    if (ret < 0)
+        goto fail;
+
+    h->is_streamed  = c->inner->is_streamed;
+    c->logical_size = ffurl_size(c->inner);
+
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_cond_init(&c->cond_main, NULL);
+    pthread_cond_init(&c->cond_background, NULL);
+
+    if ((ret = pthread_create(&c->thread, NULL, async_buffer_task, h))) {
+        av_log(h, AV_LOG_ERROR, "pthread_create failed: %s\n", strerror(ret));
+        ret = AVERROR(ret);
+        pthread_mutex_destroy(&c->lock);
+        pthread_cond_destroy(&c->cond_main);
+        pthread_cond_destroy(&c->cond_background);
+        ffurl_close(c->inner);
+        goto fail;
+    }
+
+    return 0;
+fail:
+    av_fifo_free(c->fifo);
+    c->fifo = NULL;
+    return ret;
+}
+
+static int async_read(URLContext *h, unsigned char *buf, int size)
+{
+    Context *c = h->priv_data;
+    int ret, waited = 0;
+
+    pthread_mutex_lock(&c->lock);
+    for (;;) {
+        int fill = av_fifo_size(c->fifo);
+
+        if (fill > 0) {
+            ret = FFMIN(size, fill);
+            av_fifo_generic_read(c->fifo, buf, ret, NULL);
+            c->logical_pos += ret;
+            c->fill_sum    += fill;
+            c->nb_reads++;
+            pthread_cond_signal(&c->cond_background);
+            break;
+        }
+        if (c->eof_reached) {
+            ret = c->error;
+            break;
+        }
+        if (async_check_interrupt(h)) {
+            ret = AVERROR_EXIT;
+            break;
+        }
+        if (!waited++)
+            c->nb_underruns++;
+        pthread_cond_signal(&c->cond_background);
+        pthread_cond_wait(&c->cond_main, &c->lock);
+    }
+    pthread_mutex_unlock(&c->lock);
+
+    return ret;
+}
+
+static int64_t async_seek(URLContext *h, int64_t pos, int whence)
+{
+    Context *c = h->priv_data;
+    int64_t ret;
+
+    if (whence == AVSEEK_SIZE)
+        return c->logical_size;
+    if (whence == SEEK_CUR)
+        pos += c->logical_pos;
+    else if (whence == SEEK_END) {
+        if (c->logical_size < 0)
+            return AVERROR(EINVAL);
+        pos += c->logical_size;
+    } else if (whence != SEEK_SET)
+        return AVERROR(EINVAL);
+    if (pos < 0)
+        return AVERROR(EINVAL);
+
+    pthread_mutex_lock(&c->lock);
+    /* short forward seeks are served from the buffered data */
+    if (pos >= c->logical_pos && pos - c->logical_pos <= av_fifo_size(c->fifo)) {
+        av_fifo_drain(c->fifo, pos - c->logical_pos);
+        c->logical_pos = pos;
+        pthread_cond_signal(&c->cond_background);
+        pthread_mutex_unlock(&c->lock);
+        return pos;
+    }
+    if (h->is_streamed) {
+        pthread_mutex_unlock(&c->lock);
+        return AVERROR(ENOSYS);
+    }
+
+    c->seek_request   = 1;
+    c->seek_completed = 0;
+    c->seek_pos       = pos;
+    pthread_cond_signal(&c->cond_background);
+    while (!c->seek_completed)
+        pthread_cond_wait(&c->cond_main, &c->lock);
+    ret = c->seek_ret;
+    pthread_mutex_unlock(&c->lock);
+
+    return ret;
+}
+
+static int async_close(URLContext *h)
+{
+    Context *c = h->priv_data;
+
+    pthread_mutex_lock(&c->lock);
+    c->abort_request = 1;
+    pthread_cond_signal(&c->cond_background);
+    pthread_mutex_unlock(&c->lock);
+    pthread_join(c->thread, NULL);
+
+    if (c->nb_reads)
+        av_log(h, AV_LOG_VERBOSE,
+               "%"PRId64" reads, %"PRId64" waited for data, "
+               "average fill level %"PRId64" of %d bytes\n",
+               c->nb_reads, c->nb_underruns,
+               c->fill_sum / c->nb_reads, c->buffer_size);
+
+    pthread_mutex_destroy(&c->lock);
+    pthread_cond_destroy(&c->cond_main);
+    pthread_cond_destroy(&c->cond_background);
+    av_fifo_free(c->fifo);
+    ffurl_close(c->inner);
+
+    return 0;
+}
+
+#define OFFSET(x) offsetof(Context, x)
+#define D AV_OPT_FLAG_DECODING_PARAM
+static const AVOption options[] = {
+    { "async_buffer_size", "size of the read-ahead buffer in bytes", OFFSET(buffer_size), AV_OPT_TYPE_INT, { .i64 = 4 * 1024 * 1024 }, READ_CHUNK_SIZE, INT_MAX, D },
+    { NULL }
+};
+
+static const AVClass async_context_class = {
+    .class_name = "async",
+    .item_name  = av_default_item_name,
+    .option     = options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
+URLProtocol ff_async_protocol = {
+    .name                = "async",
+    .url_open            = async_open,
+    .url_read            = async_read,
+    .url_seek            = async_seek,
+    .url_close           = async_close,
+    .priv_data_size      = sizeof(Context),
+    .priv_data_class     = &async_context_class,
+};
@@ -1040,6 +1040,7 @@ typedef struct AVFormatContext {
 #define AVFMT_FLAG_SORT_DTS    0x10000 ///< try to interleave outputted packets by dts (using this flag can slow demuxing down)
 #define AVFMT_FLAG_PRIV_OPT    0x20000 ///< Enable use of private options by delaying codec open (this could be made default once all code is converted)
 #define AVFMT_FLAG_KEEP_SIDE_DATA 0x40000 ///< Don't merge side data but keep it separate.
+#define AVFMT_FLAG_FAST_INFO   0x80000 ///< Make avformat_find_stream_info() return as soon as the codec parameters of the non-discarded streams are known
 
     /**
      * decoding: size of data to probe; encoding: unused.
@@ -1569,8 +1570,11 @@ int av_find_stream_info(AVFormatContext *ic);
  * @note this function isn't guaranteed to open all the codecs, so
  *       options being non-empty at return is a perfectly normal behavior.
  *
- * @todo Let the user decide somehow what information is needed so that
- *       we do not waste time getting stuff the user does not need.
+ * @note With AVFMT_FLAG_FAST_INFO set in ic->flags, only the codec
+ *       parameters are looked for, and the streams with discard set to
+ *       AVDISCARD_ALL before the call are skipped. This avoids reading
+ *       more data than needed to start decoding, at the cost of a less
+ *       accurate frame rate guess.
  */
 int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options);
 
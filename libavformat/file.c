@@ -31,6 +31,9 @@
 #endif
 #include <sys/stat.h>
 #include <stdlib.h>
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
 #include "os_support.h"
 #include "url.h"
 
@@ -45,14 +48,24 @@
 
 /* standard file protocol */
 
+/* read-ahead window advised to the kernel when reading from a mapping */
+#define MMAP_WILLNEED_SIZE (1 << 20)
+
 typedef struct FileContext {
     const AVClass *class;
     int fd;
     int trunc;
+    int use_mmap;
+    uint8_t *map;           ///< mapping of the whole file, NULL if not mapped
+    int64_t map_size;
+    int64_t map_pos;        ///< read position inside the mapping
+    int64_t map_advised;    ///< end of the range passed to MADV_WILLNEED
 } FileContext;
 
 static const AVOption file_options[] = {
     { "truncate", "Truncate existing files on write", offsetof(FileContext, trunc), AV_OPT_TYPE_INT, { .i64 = 1 }, 0, 1, AV_OPT_FLAG_ENCODING_PARAM },
+    /* a mapped file that is truncated while being read raises SIGBUS */
+    { "mmap", "Read regular files through a memory mapping", offsetof(FileContext, use_mmap), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { NULL }
 };
 
@@ -63,10 +76,64 @@ static const AVClass file_class = {
     .version    = LIBAVUTIL_VERSION_INT,
 };
 
+#if HAVE_MMAP
+static void file_map(URLContext *h, const struct stat *st)
+{
+    FileContext *c = h->priv_data;
+    void *map;
+
+    if (!S_ISREG(st->st_mode) || st->st_size <= 0 ||
+        st->st_size != (size_t)st->st_size)
+        return;
+
+    map = mmap(NULL, st->st_size, PROT_READ, MAP_SHARED, c->fd, 0);
+    if (map == MAP_FAILED) {
+        av_log(h, AV_LOG_VERBOSE, "mmap() failed, using read(): %s\n",
+               strerror(errno));
+        return;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(map, st->st_size, MADV_SEQUENTIAL);
+#endif
+    c->map      = map;
+    c->map_size = st->st_size;
+}
+
+static int file_read_mapped(URLContext *h, unsigned char *buf, int size)
+{
+    FileContext *c = h->priv_data;
+
+    /* like read(2), signal the end of the file with 0 */
+    if (c->map_pos >= c->map_size)
+        return 0;
+    size = FFMIN(size, c->map_size - c->map_pos);
+
+#ifdef MADV_WILLNEED
+    /* keep about one window ahead of the reader resident */
+    if (c->map_pos + size > c->map_advised - MMAP_WILLNEED_SIZE / 2) {
+        int64_t start = FFMAX(c->map_pos, c->map_advised) & ~0xFFFFLL;
+        int64_t end   = FFMIN(c->map_pos + size + MMAP_WILLNEED_SIZE, c->map_size);
+        if (end > start)
+            madvise(c->map + start, end - start, MADV_WILLNEED);
+        c->map_advised = end;
+    }
+#endif
+
+    memcpy(buf, c->map + c->map_pos, size);
+    c->map_pos += size;
+    return size;
+}
+#endif
+
 static int file_read(URLContext *h, unsigned char *buf, int size)
 {
     FileContext *c = h->priv_data;
-    int r = read(c->fd, buf, size);
+    int r;
+#if HAVE_MMAP
+    if (c->map)
+        return file_read_mapped(h, buf, size);
+#endif
+    r = read(c->fd, buf, size);
     return (-1 == r)?AVERROR(errno):r;
 }
 
@@ -113,7 +180,7 @@ static int file_open(URLContext *h, const char *filename, int flags)
 {
     FileContext *c = h->priv_data;
     int access;
-    int fd;
+    int fd, ret;
     struct stat st;
 
     av_strstart(filename, "file:", &filename);
@@ -137,7 +204,13 @@ static int file_open(URLContext *h, const char *filename, int flags)
         return AVERROR(errno);
     c->fd = fd;
 
-    h->is_streamed = !fstat(fd, &st) && S_ISFIFO(st.st_mode);
+    ret = fstat(fd, &st);
+    h->is_streamed = !ret && S_ISFIFO(st.st_mode);
+
+#if HAVE_MMAP
+    if (c->use_mmap && !(flags & AVIO_FLAG_WRITE) && !ret)
+        file_map(h, &st);
+#endif
 
     return 0;
 }
@@ -154,6 +227,23 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
         return ret < 0 ? AVERROR(errno) : (S_ISFIFO(st.st_mode) ? 0 : st.st_size);
     }
 
+#if HAVE_MMAP
+    if (c->map) {
+        if (whence == SEEK_CUR)
+            pos += c->map_pos;
+        else if (whence == SEEK_END)
+            pos += c->map_size;
+        else if (whence != SEEK_SET)
+            return AVERROR(EINVAL);
+        if (pos < 0)
+            return AVERROR(EINVAL);
+        /* restart the read-ahead at the new position */
+        if (pos < c->map_pos || pos > c->map_advised)
+            c->map_advised = pos;
+        return c->map_pos = pos;
+    }
+#endif
+
     ret = lseek(c->fd, pos, whence);
 
     return ret < 0 ? AVERROR(errno) : ret;
@@ -162,6 +252,10 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
 static int file_close(URLContext *h)
 {
     FileContext *c = h->priv_data;
+#if HAVE_MMAP
+    if (c->map)
+        munmap(c->map, c->map_size);
+#endif
     return close(c->fd);
 }
 
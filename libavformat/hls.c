@@ -36,6 +36,10 @@
 #include "avio_internal.h"
 #include "url.h"
 
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
 #define INITIAL_BUFFER_SIZE 32768
 
 /*
@@ -63,6 +67,20 @@ struct segment {
     uint8_t iv[16];
 };
 
+/*
+ * A segment downloaded ahead of time by the prefetch thread. The reader may
+ * consume it while it is still being downloaded.
+ */
+struct prefetch_entry {
+    int used;
+    int seq_no;
+    uint8_t *data;
+    unsigned int size;
+    unsigned int alloc;
+    int finished;
+    int error;
+};
+
 /*
  * Each variant has its own demuxer. If it currently is active,
  * it has an open AVIOContext too, and potentially an AVPacket
@@ -91,9 +109,25 @@ struct variant {
 
     char key_url[MAX_URL_SIZE];
     uint8_t key[16];
+
+    int reading_prefetched;     ///< the current segment is read from the prefetch cache
+    unsigned int prefetch_pos;  ///< read position in the current prefetched segment
+#if HAVE_PTHREADS
+    struct prefetch_entry *prefetch_entries;
+    int nb_prefetch_entries;    ///< the segment being read and the ones ahead of it
+    pthread_t prefetch_thread;
+    pthread_mutex_t prefetch_lock;
+    pthread_cond_t prefetch_cond;
+    int prefetch_seq_no;        ///< next segment to download
+    int prefetch_cur_seq_no;    ///< segment being read, the downloads stay prefetch ahead of it
+    int prefetch_gen;           ///< incremented when the cached segments are dropped
+    int prefetch_needed;
+    int prefetch_exit;
+#endif
 };
 
 typedef struct HLSContext {
+    const AVClass *class;
     int n_variants;
     struct variant **variants;
     int cur_seq_no;
@@ -105,6 +139,8 @@ typedef struct HLSContext {
     AVIOInterruptCB *interrupt_callback;
     char *user_agent;                    ///< holds HTTP user agent set as an AVOption to the HTTP protocol context
     char *cookies;                       ///< holds HTTP cookie values set in either the initial response or as an AVOption to the HTTP protocol context
+    char *reuse_connections;             ///< holds the HTTP reuse_connections option of the HTTP protocol context
+    int prefetch;                        ///< number of segments downloaded ahead for each variant
 } HLSContext;
 
 static int read_chomp_line(AVIOContext *s, char *buf, int maxlen)
@@ -124,11 +160,252 @@ static void free_segment_list(struct variant *var)
     var->n_segments = 0;
 }
 
+#if HAVE_PTHREADS
+/* Wait for the prefetch state to change, must be called with the prefetch
+ * lock held. The wait is bounded so that the interrupt callback is polled
+ * while a download stalls. */
+static void prefetch_wait(struct variant *v)
+{
+    int64_t t = av_gettime() + 100000;
+    struct timespec ts = { t / 1000000, t % 1000000 * 1000 };
+
+    pthread_cond_timedwait(&v->prefetch_cond, &v->prefetch_lock, &ts);
+}
+
+static void *prefetch_thread(void *arg)
+{
+    struct variant *v = arg;
+    HLSContext *c = v->parent->priv_data;
+    uint8_t buf[INITIAL_BUFFER_SIZE];
+
+    pthread_mutex_lock(&v->prefetch_lock);
+    while (!v->prefetch_exit) {
+        struct prefetch_entry *e = NULL;
+        char url[MAX_URL_SIZE];
+        URLContext *uc = NULL;
+        AVDictionary *opts = NULL;
+        int i, ret, gen, seg = v->prefetch_seq_no - v->start_seq_no;
+
+        /* keep up to prefetch segments downloaded ahead of the one read */
+        if (v->prefetch_needed && seg >= 0 && seg < v->n_segments &&
+            v->prefetch_seq_no <= v->prefetch_cur_seq_no + c->prefetch) {
+            /* encrypted segments are opened by the reader itself */
+            if (v->segments[seg]->key_type != KEY_NONE) {
+                v->prefetch_seq_no++;
+                continue;
+            }
+            for (i = 0; i < v->nb_prefetch_entries && !e; i++)
+                if (!v->prefetch_entries[i].used)
+                    e = &v->prefetch_entries[i];
+        }
+        /* do not start downloads that would be interrupted at once */
+        if (!e || ff_check_interrupt(c->interrupt_callback)) {
+            prefetch_wait(v);
+            continue;
+        }
+
+        e->used     = 1;
+        e->seq_no   = v->prefetch_seq_no++;
+        e->size     = 0;
+        e->finished = 0;
+        e->error    = 0;
+        gen = v->prefetch_gen;
+        av_strlcpy(url, v->segments[seg]->url, sizeof(url));
+        pthread_mutex_unlock(&v->prefetch_lock);
+
+        // broker prior HTTP options that should be consistent across requests
+        av_dict_set(&opts, "user-agent", c->user_agent, 0);
+        av_dict_set(&opts, "cookies", c->cookies, 0);
+        av_dict_set(&opts, "reuse_connections", c->reuse_connections, 0);
+        av_dict_set(&opts, "seekable", "0", 0);
+        ret = ffurl_open(&uc, url, AVIO_FLAG_READ,
+                         &v->parent->interrupt_callback, &opts);
+        av_dict_free(&opts);
+
+        while (ret >= 0 && (ret = ffurl_read(uc, buf, sizeof(buf))) > 0) {
+            uint8_t *data;
+
+            pthread_mutex_lock(&v->prefetch_lock);
+            if (gen != v->prefetch_gen || v->prefetch_exit) {
+                pthread_mutex_unlock(&v->prefetch_lock);
+                break;
+            }
+            data = av_fast_realloc(e->data, &e->alloc, e->size + ret);
+            if (!data) {
+                pthread_mutex_unlock(&v->prefetch_lock);
+                ret = AVERROR(ENOMEM);
+                break;
+            }
+            e->data = data;
+            memcpy(e->data + e->size, buf, ret);
+            e->size += ret;
+            pthread_cond_broadcast(&v->prefetch_cond);
+            pthread_mutex_unlock(&v->prefetch_lock);
+        }
+        if (uc)
+            ffurl_close(uc);
+
+        pthread_mutex_lock(&v->prefetch_lock);
+        if (gen == v->prefetch_gen) {
+            e->finished = 1;
+            e->error    = ret == AVERROR_EOF ? 0 : FFMIN(ret, 0);
+            pthread_cond_broadcast(&v->prefetch_cond);
+        }
+    }
+    pthread_mutex_unlock(&v->prefetch_lock);
+
+    return NULL;
+}
+
+static struct prefetch_entry *find_prefetched(struct variant *v, int seq_no)
+{
+    int i;
+
+    for (i = 0; i < v->nb_prefetch_entries; i++)
+        if (v->prefetch_entries[i].used && v->prefetch_entries[i].seq_no == seq_no)
+            return &v->prefetch_entries[i];
+    return NULL;
+}
+
+/* Drop the cached segments and restart the downloads at the current one,
+ * must be called with the prefetch lock held. */
+static void reset_prefetch(struct variant *v)
+{
+    int i;
+
+    for (i = 0; i < v->nb_prefetch_entries; i++)
+        v->prefetch_entries[i].used = 0;
+    v->prefetch_gen++;
+    v->prefetch_seq_no     = v->cur_seq_no;
+    v->prefetch_cur_seq_no = v->cur_seq_no;
+    v->prefetch_needed = v->needed;
+    pthread_cond_broadcast(&v->prefetch_cond);
+}
+
+static void flush_prefetch(struct variant *v)
+{
+    if (!v->prefetch_entries)
+        return;
+
+    pthread_mutex_lock(&v->prefetch_lock);
+    reset_prefetch(v);
+    pthread_mutex_unlock(&v->prefetch_lock);
+    v->reading_prefetched = 0;
+}
+
+/* Prepare reading the current segment from the prefetch cache, return 0
+ * if it has to be opened directly. */
+static int open_prefetched(struct variant *v)
+{
+    int i;
+
+    if (!v->prefetch_entries)
+        return 0;
+
+    pthread_mutex_lock(&v->prefetch_lock);
+    for (i = 0; i < v->nb_prefetch_entries; i++)
+        if (v->prefetch_entries[i].seq_no < v->cur_seq_no)
+            v->prefetch_entries[i].used = 0;
+    v->prefetch_cur_seq_no = v->cur_seq_no;
+    if (v->segments[v->cur_seq_no - v->start_seq_no]->key_type != KEY_NONE) {
+        pthread_cond_broadcast(&v->prefetch_cond);
+        pthread_mutex_unlock(&v->prefetch_lock);
+        return 0;
+    }
+    if (!find_prefetched(v, v->cur_seq_no))
+        reset_prefetch(v);
+    pthread_cond_broadcast(&v->prefetch_cond);
+    pthread_mutex_unlock(&v->prefetch_lock);
+
+    v->reading_prefetched = 1;
+    v->prefetch_pos       = 0;
+    return 1;
+}
+
+static int read_prefetched(struct variant *v, uint8_t *buf, int buf_size)
+{
+    HLSContext *c = v->parent->priv_data;
+    struct prefetch_entry *e;
+    int ret;
+
+    pthread_mutex_lock(&v->prefetch_lock);
+    while (!(e = find_prefetched(v, v->cur_seq_no)) ||
+           (e->size <= v->prefetch_pos && !e->finished)) {
+        if (ff_check_interrupt(c->interrupt_callback)) {
+            pthread_mutex_unlock(&v->prefetch_lock);
+            return AVERROR_EXIT;
+        }
+        prefetch_wait(v);
+    }
+    if (e->size > v->prefetch_pos) {
+        ret = FFMIN(buf_size, e->size - v->prefetch_pos);
+        memcpy(buf, e->data + v->prefetch_pos, ret);
+        v->prefetch_pos += ret;
+    } else {
+        ret = e->error ? e->error : AVERROR_EOF;
+        /* retry the download if the segment could not be opened at all */
+        if (e->error && !e->size)
+            e->used = 0;
+    }
+    pthread_mutex_unlock(&v->prefetch_lock);
+
+    return ret;
+}
+
+static int start_prefetch(HLSContext *c, struct variant *v)
+{
+    int ret;
+
+    v->nb_prefetch_entries = c->prefetch + 1;
+    v->prefetch_entries = av_mallocz(v->nb_prefetch_entries * sizeof(*v->prefetch_entries));
+    if (!v->prefetch_entries)
+        return AVERROR(ENOMEM);
+
+    pthread_mutex_init(&v->prefetch_lock, NULL);
+    pthread_cond_init(&v->prefetch_cond, NULL);
+    /* the segment the header was probed from is already open */
+    v->prefetch_seq_no     = v->cur_seq_no + !!v->input;
+    v->prefetch_cur_seq_no = v->cur_seq_no;
+    v->prefetch_needed = v->needed;
+
+    if ((ret = pthread_create(&v->prefetch_thread, NULL, prefetch_thread, v))) {
+        pthread_mutex_destroy(&v->prefetch_lock);
+        pthread_cond_destroy(&v->prefetch_cond);
+        av_freep(&v->prefetch_entries);
+        return AVERROR(ret);
+    }
+    return 0;
+}
+
+static void stop_prefetch(HLSContext *c, struct variant *v)
+{
+    int i;
+
+    if (!v->prefetch_entries)
+        return;
+
+    pthread_mutex_lock(&v->prefetch_lock);
+    v->prefetch_exit = 1;
+    pthread_cond_broadcast(&v->prefetch_cond);
+    pthread_mutex_unlock(&v->prefetch_lock);
+    pthread_join(v->prefetch_thread, NULL);
+
+    pthread_mutex_destroy(&v->prefetch_lock);
+    pthread_cond_destroy(&v->prefetch_cond);
+    for (i = 0; i < v->nb_prefetch_entries; i++)
+        av_free(v->prefetch_entries[i].data);
+    av_freep(&v->prefetch_entries);
+}
+#endif
+
 static void free_variant_list(HLSContext *c)
 {
     int i;
     for (i = 0; i < c->n_variants; i++) {
         struct variant *var = c->variants[i];
+#if HAVE_PTHREADS
+        stop_prefetch(c, var);
+#endif
         free_segment_list(var);
         av_free_packet(&var->pkt);
         av_free(var->pb.buffer);
@@ -143,6 +420,7 @@ static void free_variant_list(HLSContext *c)
     av_freep(&c->variants);
     av_freep(&c->cookies);
     av_freep(&c->user_agent);
+    av_freep(&c->reuse_connections);
     c->n_variants = 0;
 }
 
@@ -224,6 +502,7 @@ static int parse_playlist(HLSContext *c, const char *url,
         // broker prior HTTP options that should be consistent across requests
         av_dict_set(&opts, "user-agent", c->user_agent, 0);
         av_dict_set(&opts, "cookies", c->cookies, 0);
+        av_dict_set(&opts, "reuse_connections", c->reuse_connections, 0);
 
         ret = avio_open2(&in, url, AVIO_FLAG_READ,
                          c->interrupt_callback, &opts);
@@ -346,6 +625,7 @@ static int open_input(HLSContext *c, struct variant *var)
     // broker prior HTTP options that should be consistent across requests
     av_dict_set(&opts, "user-agent", c->user_agent, 0);
     av_dict_set(&opts, "cookies", c->cookies, 0);
+    av_dict_set(&opts, "reuse_connections", c->reuse_connections, 0);
     av_dict_set(&opts, "seekable", "0", 0);
 
     if (seg->key_type == KEY_NONE) {
@@ -407,7 +687,7 @@ static int read_data(void *opaque, uint8_t *buf, int buf_size)
     int ret, i;
 
 restart:
-    if (!v->input) {
+    if (!v->input && !v->reading_prefetched) {
         /* If this is a live stream and the reload interval has elapsed since
          * the last playlist reload, reload the variant playlists now. */
         int64_t reload_interval = v->n_segments > 0 ?
@@ -418,7 +698,19 @@ restart:
 reload:
         if (!v->finished &&
             av_gettime() - v->last_load_time >= reload_interval) {
-            if ((ret = parse_playlist(c, v->url, v, NULL)) < 0)
+#if HAVE_PTHREADS
+            /* the prefetch thread reads the segment list */
+            if (v->prefetch_entries)
+                pthread_mutex_lock(&v->prefetch_lock);
+#endif
+            ret = parse_playlist(c, v->url, v, NULL);
+#if HAVE_PTHREADS
+            if (v->prefetch_entries) {
+                pthread_cond_broadcast(&v->prefetch_cond);
+                pthread_mutex_unlock(&v->prefetch_lock);
+            }
+#endif
+            if (ret < 0)
                 return ret;
             /* If we need to reload the playlist again below (if
              * there's still no more segments), switch to a reload
@@ -443,15 +735,32 @@ reload:
             goto reload;
         }
 
-        ret = open_input(c, v);
-        if (ret < 0)
+#if HAVE_PTHREADS
+        if (!open_prefetched(v))
+#endif
+        {
+            ret = open_input(c, v);
+            if (ret < 0)
+                return ret;
+        }
+    }
+#if HAVE_PTHREADS
+    if (v->reading_prefetched) {
+        ret = read_prefetched(v, buf, buf_size);
+        if (ret > 0)
             return ret;
+        v->reading_prefetched = 0;
+        if (ret != AVERROR_EOF && !v->prefetch_pos)
+            return ret;
+    } else
+#endif
+    {
+        ret = ffurl_read(v->input, buf, buf_size);
+        if (ret > 0)
+            return ret;
+        ffurl_close(v->input);
+        v->input = NULL;
     }
-    ret = ffurl_read(v->input, buf, buf_size);
-    if (ret > 0)
-        return ret;
-    ffurl_close(v->input);
-    v->input = NULL;
     v->cur_seq_no++;
 
     c->end_of_segment = 1;
@@ -466,6 +775,9 @@ reload:
         }
     }
     if (!v->needed) {
+#if HAVE_PTHREADS
+        flush_prefetch(v);
+#endif
         av_log(v->parent, AV_LOG_INFO, "No longer receiving variant %d\n",
                v->index);
         return AVERROR_EOF;
@@ -494,6 +806,10 @@ static int hls_read_header(AVFormatContext *s)
         av_opt_get(u->priv_data, "cookies", 0, (uint8_t**)&(c->cookies));
         if (c->cookies && !strlen(c->cookies))
             av_freep(&c->cookies);
+
+        // get whether idle connections may be reused for the other requests
+        av_freep(&c->reuse_connections);
+        av_opt_get(u->priv_data, "reuse_connections", 0, (uint8_t**)&(c->reuse_connections));
     }
 
     if ((ret = parse_playlist(c, s->filename, NULL, s->pb)) < 0)
@@ -606,6 +922,16 @@ static int hls_read_header(AVFormatContext *s)
         stream_offset += v->ctx->nb_streams;
     }
 
+#if HAVE_PTHREADS
+    if (c->prefetch > 0) {
+        for (i = 0; i < c->n_variants; i++) {
+            struct variant *v = c->variants[i];
+            if (v->ctx && (ret = start_prefetch(c, v)) < 0)
+                goto fail;
+        }
+    }
+#endif
+
     c->first_packet = 1;
     c->first_timestamp = AV_NOPTS_VALUE;
     c->seek_timestamp  = AV_NOPTS_VALUE;
@@ -638,12 +964,18 @@ static int recheck_discard_flags(AVFormatContext *s, int first)
             changed = 1;
             v->cur_seq_no = c->cur_seq_no;
             v->pb.eof_reached = 0;
+#if HAVE_PTHREADS
+            flush_prefetch(v);
+#endif
             av_log(s, AV_LOG_INFO, "Now receiving variant %d\n", i);
         } else if (first && !v->cur_needed && v->needed) {
             if (v->input)
                 ffurl_close(v->input);
             v->input = NULL;
             v->needed = 0;
+#if HAVE_PTHREADS
+            flush_prefetch(v);
+#endif
             changed = 1;
             av_log(s, AV_LOG_INFO, "No longer receiving variant %d\n", i);
         }
@@ -797,12 +1129,29 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
             }
             pos += var->segments[j]->duration;
         }
+#if HAVE_PTHREADS
+        flush_prefetch(var);
+#endif
         if (ret)
             c->seek_timestamp = AV_NOPTS_VALUE;
     }
     return ret;
 }
 
+#define OFFSET(x) offsetof(HLSContext, x)
+#define FLAGS AV_OPT_FLAG_DECODING_PARAM
+static const AVOption hls_options[] = {
+    { "prefetch", "number of segments to download ahead for each variant", OFFSET(prefetch), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 64, FLAGS },
+    { NULL },
+};
+
+static const AVClass hls_class = {
+    .class_name = "hls demuxer",
+    .item_name  = av_default_item_name,
+    .option     = hls_options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
 static int hls_probe(AVProbeData *p)
 {
     /* Require #EXTM3U at the start, and either one of the ones below
@@ -825,4 +1174,5 @@ AVInputFormat ff_hls_demuxer = {
     .read_packet    = hls_read_packet,
     .read_close     = hls_close,
     .read_seek      = hls_read_seek,
+    .priv_class     = &hls_class,
 };
@@ -29,6 +29,7 @@
 
 #include "avformat.h"
 #include "internal.h"
+#include "segwriter.h"
 
 typedef struct ListEntry {
     char  name[1024];
@@ -54,7 +55,8 @@ typedef struct HLSContext {
     ListEntry *list;
     ListEntry *end_list;
     char *basename;
-    AVIOContext *pb;
+    SegWriter *writer;     ///< closes the segments and writes the playlist in the background
+    int queue_size;        // Set by a private option.
 } HLSContext;
 
 static int hls_mux_init(AVFormatContext *s)
@@ -126,36 +128,37 @@ static void free_entries(HLSContext *hls)
 static int hls_window(AVFormatContext *s, int last)
 {
     HLSContext *hls = s->priv_data;
+    AVIOContext *pb;
     ListEntry *en;
+    uint8_t *buf;
     int target_duration = 0;
-    int ret = 0;
+    int ret, size;
 
-    if ((ret = avio_open2(&hls->pb, s->filename, AVIO_FLAG_WRITE,
-                          &s->interrupt_callback, NULL)) < 0)
-        goto fail;
+    if ((ret = avio_open_dyn_buf(&pb)) < 0)
+        return ret;
 
     for (en = hls->list; en; en = en->next) {
         if (target_duration < en->duration)
             target_duration = en->duration;
     }
 
-    avio_printf(hls->pb, "#EXTM3U\n");
-    avio_printf(hls->pb, "#EXT-X-VERSION:3\n");
-    avio_printf(hls->pb, "#EXT-X-TARGETDURATION:%d\n", target_duration);
-    avio_printf(hls->pb, "#EXT-X-MEDIA-SEQUENCE:%"PRId64"\n",
+    avio_printf(pb, "#EXTM3U\n");
+    avio_printf(pb, "#EXT-X-VERSION:3\n");
+    avio_printf(pb, "#EXT-X-TARGETDURATION:%d\n", target_duration);
+    avio_printf(pb, "#EXT-X-MEDIA-SEQUENCE:%"PRId64"\n",
                 FFMAX(0, hls->sequence - hls->size));
 
     for (en = hls->list; en; en = en->next) {
-        avio_printf(hls->pb, "#EXTINF:%d,\n", en->duration);
-        avio_printf(hls->pb, "%s\n", en->name);
+        avio_printf(pb, "#EXTINF:%d,\n", en->duration);
+        avio_printf(pb, "%s\n", en->name);
     }
 
     if (last)
-        avio_printf(hls->pb, "#EXT-X-ENDLIST\n");
+        avio_printf(pb, "#EXT-X-ENDLIST\n");
 
-fail:
-    avio_closep(&hls->pb);
-    return ret;
+    size = avio_close_dyn_buf(pb, &buf);
+    return ff_segwriter_write_file(hls->writer, s->filename, buf, size,
+                                   &s->interrupt_callback);
 }
 
 static int hls_start(AVFormatContext *s)
@@ -164,8 +167,13 @@ static int hls_start(AVFormatContext *s)
     AVFormatContext *oc = c->avf;
     int err = 0;
 
-    if (c->wrap)
+    if (c->wrap && c->number >= c->wrap) {
+        /* the names are reused from here on, let the segments still being
+         * closed in the background finish before one of them is truncated */
+        if ((err = ff_segwriter_flush(c->writer)) < 0)
+            return err;
         c->number %= c->wrap;
+    }
 
     if (av_get_frame_filename(oc->filename, sizeof(oc->filename),
                               c->basename, c->number++) < 0) {
@@ -228,6 +236,9 @@ static int hls_write_header(AVFormatContext *s)
 
     av_strlcat(hls->basename, pattern, basename_size);
 
+    if ((ret = ff_segwriter_alloc(&hls->writer, hls->queue_size, s)) < 0)
+        goto fail;
+
     if ((ret = hls_mux_init(s)) < 0)
         goto fail;
 
@@ -241,6 +252,7 @@ static int hls_write_header(AVFormatContext *s)
 fail:
     if (ret) {
         av_free(hls->basename);
+        ff_segwriter_free(&hls->writer);
         if (hls->avf)
             avformat_free_context(hls->avf);
     }
@@ -283,7 +295,11 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         hls->duration = 0;
 
         av_write_frame(oc, NULL); /* Flush any buffered data */
-        avio_close(oc->pb);
+        /* closed before the playlist referencing it is written */
+        ret = ff_segwriter_close(hls->writer, oc->pb);
+        oc->pb = NULL;
+        if (ret < 0)
+            return ret;
 
         ret = hls_start(s);
 
@@ -307,15 +323,15 @@ static int hls_write_trailer(struct AVFormatContext *s)
     AVFormatContext *oc = hls->avf;
 
     av_write_trailer(oc);
-    avio_closep(&oc->pb);
+    ff_segwriter_close(hls->writer, oc->pb);
+    oc->pb = NULL;
     avformat_free_context(oc);
     av_free(hls->basename);
     append_entry(hls, hls->duration);
     hls_window(s, 1);
 
     free_entries(hls);
-    avio_close(hls->pb);
-    return 0;
+    return ff_segwriter_free(&hls->writer);
 }
 
 #define OFFSET(x) offsetof(HLSContext, x)
@@ -325,6 +341,7 @@ static const AVOption options[] = {
     {"hls_time",      "set segment length in seconds",           OFFSET(time),    AV_OPT_TYPE_FLOAT,  {.dbl = 2},     0, FLT_MAX, E},
     {"hls_list_size", "set maximum number of playlist entries",  OFFSET(size),    AV_OPT_TYPE_INT,    {.i64 = 5},     0, INT_MAX, E},
     {"hls_wrap",      "set number after which the index wraps",  OFFSET(wrap),    AV_OPT_TYPE_INT,    {.i64 = 0},     0, INT_MAX, E},
+    {"hls_queue_size", "set number of segment and playlist writes done in the background, 0 to write synchronously", OFFSET(queue_size), AV_OPT_TYPE_INT, {.i64 = 4}, 0, INT_MAX, E},
     { NULL },
 };
 
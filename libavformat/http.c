@@ -20,6 +20,7 @@
  */
 
 #include "libavutil/avstring.h"
+#include "libavutil/time.h"
 #include "avformat.h"
 #include "internal.h"
 #include "network.h"
@@ -28,6 +29,9 @@
 #include "httpauth.h"
 #include "url.h"
 #include "libavutil/opt.h"
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
 
 /* XXX: POST protocol is not completely implemented because ffmpeg uses
    only a subset of it. */
@@ -39,6 +43,14 @@
 #define BUFFER_SIZE MAX_URL_SIZE
 #define MAX_REDIRECTS 8
 
+/* The connection pool needs a lock that works without a lock manager,
+ * since several threads may open http URLs at the same time. */
+#define HTTP_POOL (HAVE_PTHREADS || !HAVE_THREADS)
+#define POOL_SIZE          16
+#define POOL_MAX_PER_HOST   4
+/* lower protocol url (at most 1024 bytes) plus the rw_timeout suffix */
+#define POOL_KEY_SIZE      (1024 + 16)
+
 typedef struct {
     const AVClass *class;
     URLContext *hd;
@@ -65,6 +77,11 @@ typedef struct {
     int rw_timeout;
     char *mime_type;
     char *cookies;          ///< holds newline (\n) delimited Set-Cookie header field values (without the "Set-Cookie: " field name)
+    int reuse_connections;
+    int idle_timeout;
+    char pool_key[POOL_KEY_SIZE]; ///< key of hd in the connection pool, empty if hd must not be pooled
+    int conn_reused;        ///< hd was taken from the connection pool
+    int keep_alive;         ///< the server keeps the connection open after the reply
 } HTTPContext;
 
 #define OFFSET(x) offsetof(HTTPContext, x)
@@ -82,6 +99,8 @@ static const AVOption options[] = {
 {"timeout", "set timeout of socket I/O operations", OFFSET(rw_timeout), AV_OPT_TYPE_INT, {.i64 = -1}, -1, INT_MAX, D|E },
 {"mime_type", "set MIME type", OFFSET(mime_type), AV_OPT_TYPE_STRING, {0}, 0, 0, 0 },
 {"cookies", "set cookies to be sent in applicable future requests, use newline delimited Set-Cookie HTTP field value syntax", OFFSET(cookies), AV_OPT_TYPE_STRING, {0}, 0, 0, 0 },
+{"reuse_connections", "reuse idle persistent connections across requests", OFFSET(reuse_connections), AV_OPT_TYPE_INT, {.i64 = 1}, 0, 1, D },
+{"idle_timeout", "set time in seconds an idle persistent connection is kept open", OFFSET(idle_timeout), AV_OPT_TYPE_INT, {.i64 = 10}, 0, INT_MAX, D },
 {NULL}
 };
 #define HTTP_CLASS(flavor)\
@@ -108,6 +127,136 @@ void ff_http_init_auth_state(URLContext *dest, const URLContext *src)
            sizeof(HTTPAuthState));
 }
 
+#if HTTP_POOL
+typedef struct HTTPIdleConnection {
+    URLContext *hd;
+    char key[POOL_KEY_SIZE];
+    int64_t expires;
+} HTTPIdleConnection;
+
+static HTTPIdleConnection pool[POOL_SIZE];
+#if HAVE_PTHREADS
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+#define POOL_LOCK()   pthread_mutex_lock(&pool_lock)
+#define POOL_UNLOCK() pthread_mutex_unlock(&pool_lock)
+#else
+#define POOL_LOCK()
+#define POOL_UNLOCK()
+#endif
+
+/* must be called with the pool lock held */
+static void pool_expire(int64_t now)
+{
+    int i;
+    for (i = 0; i < POOL_SIZE; i++)
+        if (pool[i].hd && pool[i].expires <= now)
+            ffurl_closep(&pool[i].hd);
+}
+
+/**
+ * Take an idle connection to the given host from the pool.
+ * Connections the server has closed or sent data on are dropped.
+ */
+static URLContext *pool_get(const char *key)
+{
+    URLContext *hd = NULL;
+    int i;
+
+    POOL_LOCK();
+    pool_expire(av_gettime());
+    for (i = 0; i < POOL_SIZE && !hd; i++) {
+        struct pollfd p = { 0, POLLIN, 0 };
+
+        if (!pool[i].hd || strcmp(pool[i].key, key))
+            continue;
+        p.fd = ffurl_get_file_handle(pool[i].hd);
+        if (poll(&p, 1, 0) != 0) {
+            ffurl_closep(&pool[i].hd);
+            continue;
+        }
+        hd = pool[i].hd;
+        pool[i].hd = NULL;
+    }
+    POOL_UNLOCK();
+
+    return hd;
+}
+
+/**
+ * Put a connection into the pool, or close it if the host already has
+ * POOL_MAX_PER_HOST idle connections or the pool is full.
+ */
+static void pool_put(URLContext *hd, const char *key, int idle_timeout)
+{
+    int64_t now = av_gettime();
+    int i, free_slot = -1, count = 0;
+
+    POOL_LOCK();
+    pool_expire(now);
+    for (i = 0; i < POOL_SIZE; i++) {
+        if (!pool[i].hd) {
+            if (free_slot < 0)
+                free_slot = i;
+        } else if (!strcmp(pool[i].key, key)) {
+            count++;
+        }
+    }
+    if (free_slot >= 0 && count < POOL_MAX_PER_HOST && idle_timeout > 0) {
+        /* the interrupt callback belongs to the context that opened it */
+        hd->interrupt_callback.callback = NULL;
+        hd->interrupt_callback.opaque   = NULL;
+        pool[free_slot].hd      = hd;
+        pool[free_slot].expires = now + idle_timeout * 1000000LL;
+        av_strlcpy(pool[free_slot].key, key, sizeof(pool[free_slot].key));
+        hd = NULL;
+    }
+    POOL_UNLOCK();
+
+    if (hd)
+        ffurl_close(hd);
+}
+#endif
+
+void ff_http_close_pool(void)
+{
+#if HTTP_POOL
+    int i;
+
+    POOL_LOCK();
+    for (i = 0; i < POOL_SIZE; i++)
+        if (pool[i].hd)
+            ffurl_closep(&pool[i].hd);
+    POOL_UNLOCK();
+#endif
+}
+
+/**
+ * Check if the reply on the current connection has been read completely
+ * and the server keeps the connection open for another request.
+ */
+static int http_connection_reusable(HTTPContext *s)
+{
+    return HTTP_POOL && s->hd && s->pool_key[0] && s->keep_alive &&
+           s->end_header && s->chunksize < 0 && s->filesize >= 0 &&
+           s->off == s->filesize && s->buf_ptr == s->buf_end;
+}
+
+/**
+ * Close the current connection, or hand it over to the connection pool
+ * if it can be reused.
+ */
+static void http_release_connection(HTTPContext *s)
+{
+#if HTTP_POOL
+    if (http_connection_reusable(s)) {
+        pool_put(s->hd, s->pool_key, s->idle_timeout);
+        s->hd = NULL;
+        return;
+    }
+#endif
+    ffurl_closep(&s->hd);
+}
+
 /* return non zero if error */
 static int http_open_cnx(URLContext *h)
 {
@@ -117,8 +266,10 @@ static int http_open_cnx(URLContext *h)
     char path1[MAX_URL_SIZE];
     char buf[1024], urlbuf[MAX_URL_SIZE];
     int port, use_proxy, err, location_changed = 0, redirects = 0, attempts = 0;
+    int use_pool = 1;
     HTTPAuthType cur_auth_type, cur_proxy_auth_type;
     HTTPContext *s = h->priv_data;
+    int64_t off = s->off;
 
     /* fill the dest addr */
  redo:
@@ -158,6 +309,24 @@ static int http_open_cnx(URLContext *h)
 
     ff_url_join(buf, sizeof(buf), lower_proto, NULL, hostname, port, NULL);
 
+#if HTTP_POOL
+    if (!s->hd) {
+        /* only plain GET requests on tcp connections go through the pool */
+        s->pool_key[0] = '\0';
+        s->conn_reused = 0;
+        if (s->reuse_connections && !strcmp(lower_proto, "tcp") &&
+            !(h->flags & AVIO_FLAG_WRITE) && !s->post_data) {
+            /* a truncated key could match another url, never pool those */
+            if (snprintf(s->pool_key, sizeof(s->pool_key), "%s %d",
+                         buf, s->rw_timeout) >= sizeof(s->pool_key))
+                s->pool_key[0] = '\0';
+            else if (use_pool && (s->hd = pool_get(s->pool_key))) {
+                s->hd->interrupt_callback = h->interrupt_callback;
+                s->conn_reused = 1;
+            }
+        }
+    }
+#endif
     if (!s->hd) {
         AVDictionary *opts = NULL;
         char opts_format[20];
@@ -174,8 +343,18 @@ static int http_open_cnx(URLContext *h)
 
     cur_auth_type = s->auth_state.auth_type;
     cur_proxy_auth_type = s->auth_state.auth_type;
-    if (http_connect(h, path, local_path, hoststr, auth, proxyauth, &location_changed) < 0)
+    s->line_count = 0;
+    if (http_connect(h, path, local_path, hoststr, auth, proxyauth, &location_changed) < 0) {
+        if (s->conn_reused && !s->line_count) {
+            /* the server closed the idle connection, retry on a new one */
+            av_log(h, AV_LOG_DEBUG, "Reused connection failed, reconnecting\n");
+            ffurl_closep(&s->hd);
+            s->off   = off;
+            use_pool = 0;
+            goto redo;
+        }
         goto fail;
+    }
     attempts++;
     if (s->http_code == 401) {
         if ((cur_auth_type == HTTP_AUTH_NONE || s->auth_state.stale) &&
@@ -303,6 +482,7 @@ static int process_line(URLContext *h, char *line, int line_count,
         while (av_isspace(*p))
             p++;
         s->http_code = strtol(p, &end, 10);
+        s->keep_alive = !av_strncasecmp(line, "HTTP/1.1", 8);
 
         av_dlog(NULL, "http_code=%d\n", s->http_code);
 
@@ -355,8 +535,12 @@ static int process_line(URLContext *h, char *line, int line_count,
         } else if (!av_strcasecmp (tag, "Proxy-Authenticate")) {
             ff_http_auth_handle_header(&s->proxy_auth_state, tag, p);
         } else if (!av_strcasecmp (tag, "Connection")) {
-            if (!strcmp(p, "close"))
-                s->willclose = 1;
+            if (!strcmp(p, "close")) {
+                s->willclose  = 1;
+                s->keep_alive = 0;
+            } else if (!av_strcasecmp(p, "keep-alive")) {
+                s->keep_alive = 1;
+            }
         } else if (!av_strcasecmp (tag, "Server") && !av_strcasecmp (p, "AkamaiGHost")) {
             s->is_akamai = 1;
         } else if (!av_strcasecmp (tag, "Content-Type")) {
@@ -552,7 +736,7 @@ static int http_connect(URLContext *h, const char *path, const char *local_path,
                            "Range: bytes=%"PRId64"-\r\n", s->off);
 
     if (!has_header(s->headers, "\r\nConnection: ")) {
-        if (s->multiple_requests) {
+        if (s->multiple_requests || s->pool_key[0]) {
             len += av_strlcpy(headers + len, "Connection: keep-alive\r\n",
                               sizeof(headers) - len);
         } else {
@@ -748,7 +932,7 @@ static int http_close(URLContext *h)
     }
 
     if (s->hd)
-        ffurl_closep(&s->hd);
+        http_release_connection(s);
     return ret;
 }
 
@@ -768,6 +952,11 @@ static int64_t http_seek(URLContext *h, int64_t off, int whence)
     /* we save the old context in case the seek fails */
     old_buf_size = s->buf_end - s->buf_ptr;
     memcpy(old_buf, s->buf_ptr, old_buf_size);
+    /* a connection at the end of its reply can serve the new request */
+    if (http_connection_reusable(s)) {
+        http_release_connection(s);
+        old_hd = NULL;
+    }
     s->hd = NULL;
     if (whence == SEEK_CUR)
         off += s->off;
@@ -784,7 +973,8 @@ static int64_t http_seek(URLContext *h, int64_t off, int whence)
         s->off = old_off;
         return -1;
     }
-    ffurl_close(old_hd);
+    if (old_hd)
+        ffurl_close(old_hd);
     return off;
 }
 
@@ -3489,6 +3489,62 @@ static int mov_create_timecode_track(AVFormatContext *s, int index, int src_inde
     return ret;
 }
 
+/**
+ * Estimate an upper bound of the moov size from the expected number of
+ * samples of every stream, so that faststart can reserve its space.
+ *
+ * @return the estimated size, or 0 if the number of samples is unknown
+ */
+static int estimate_moov_size(AVFormatContext *s)
+{
+    double duration = s->duration > 0 ? s->duration / (double)AV_TIME_BASE : 0;
+    int64_t size = 4096;
+    int i;
+
+    for (i = 0; i < s->nb_streams; i++) {
+        AVStream *st = s->streams[i];
+        AVCodecContext *enc = st->codec;
+        double nb_samples = st->nb_frames;
+        int sample_size;
+
+        if (!nb_samples && st->duration > 0 && st->time_base.num)
+            duration = FFMAX(duration, st->duration * av_q2d(st->time_base));
+
+        switch (enc->codec_type) {
+        case AVMEDIA_TYPE_VIDEO:
+            if (!nb_samples && duration) {
+                if (st->avg_frame_rate.num && st->avg_frame_rate.den)
+                    nb_samples = duration * av_q2d(st->avg_frame_rate);
+                else if (enc->time_base.num)
+                    nb_samples = duration / (av_q2d(enc->time_base) * enc->ticks_per_frame);
+            }
+            /* stsz, stts, ctts and one chunk offset per sample */
+            sample_size = 4 + 8 + 8 + 8;
+            break;
+        case AVMEDIA_TYPE_AUDIO:
+            if (!nb_samples && duration && enc->sample_rate)
+                nb_samples = duration * enc->sample_rate /
+                             (enc->frame_size > 0 ? enc->frame_size : 1024);
+            /* stsz and chunk offsets, the other tables are mostly constant */
+            sample_size = 4 + 8;
+            break;
+        default:
+            /* few and unpredictable samples, e.g. subtitles or timecodes */
+            if (!nb_samples)
+                nb_samples = 1024;
+            sample_size = 4 + 8 + 8 + 8;
+            break;
+        }
+        if (!nb_samples)
+            return 0;
+        size += 1024 + nb_samples * sample_size;
+    }
+    if (size > INT_MAX / 2)
+        return 0;
+    /* keep a margin for the rate variations */
+    return size + size / 8;
+}
+
 static int mov_write_header(AVFormatContext *s)
 {
     AVIOContext *pb = s->pb;
@@ -3504,12 +3560,17 @@ static int mov_write_header(AVFormatContext *s)
                       FF_MOV_FLAG_FRAG_CUSTOM))
         mov->flags |= FF_MOV_FLAG_FRAGMENT;
 
-    /* faststart: moov at the beginning of the file, if supported */
+    /* faststart: moov at the beginning of the file, if supported; when its
+     * size can be estimated, the space is reserved so that no second pass
+     * is needed, unless the estimate turns out to be too small */
     if (mov->flags & FF_MOV_FLAG_FASTSTART) {
         if (mov->flags & FF_MOV_FLAG_FRAGMENT)
             mov->flags &= ~FF_MOV_FLAG_FASTSTART;
-        else
+        else if (!mov->reserved_moov_size &&
+                 !(mov->reserved_moov_size = estimate_moov_size(s)))
             mov->reserved_moov_size = -1;
+        else
+            mov->reserved_moov_size = FFMAX(mov->reserved_moov_size, 8);
     }
 
     if (!supports_edts(mov) && s->avoid_negative_ts < 0) {
@@ -3690,7 +3751,12 @@ static int mov_write_header(AVFormatContext *s)
 
     if(mov->reserved_moov_size){
         mov->reserved_moov_pos= avio_tell(pb);
-        if (mov->reserved_moov_size > 0)
+        if (mov->reserved_moov_size > 0 && mov->flags & FF_MOV_FLAG_FASTSTART) {
+            /* a valid atom, in case the data has to be shifted anyway */
+            avio_wb32(pb, mov->reserved_moov_size);
+            ffio_wfourcc(pb, "free");
+            ffio_fill(pb, 0, mov->reserved_moov_size - 8);
+        } else if (mov->reserved_moov_size > 0)
             avio_skip(pb, mov->reserved_moov_size);
     }
 
@@ -3882,6 +3948,17 @@ static int mov_write_trailer(AVFormatContext *s)
             ffio_wfourcc(pb, "mdat");
             avio_wb64(pb, mov->mdat_size + 16);
         }
+
+        if (mov->reserved_moov_size > 0 && mov->flags & FF_MOV_FLAG_FASTSTART) {
+            int moov_size = get_moov_size(s);
+            if (moov_size < 0)
+                return moov_size;
+            if (moov_size + 8 > mov->reserved_moov_size) {
+                av_log(s, AV_LOG_INFO, "Reserved moov space too small, %d bytes "
+                       "needed instead of %d\n", moov_size + 8, mov->reserved_moov_size);
+                mov->reserved_moov_size = -1;
+            }
+        }
         avio_seek(pb, mov->reserved_moov_size > 0 ? mov->reserved_moov_pos : moov_pos, SEEK_SET);
 
         if (mov->reserved_moov_size == -1) {
@@ -3901,8 +3978,7 @@ static int mov_write_trailer(AVFormatContext *s)
             }
             avio_wb32(pb, size);
             ffio_wfourcc(pb, "free");
-            for(i=0; i<size; i++)
-                avio_w8(pb, 0);
+            ffio_fill(pb, 0, size - 8);
             avio_seek(pb, moov_pos, SEEK_SET);
         } else {
             mov_write_moov_tag(pb, mov, s);
@@ -117,6 +117,15 @@ struct MpegTSContext {
     /** to detect seek                                       */
     int64_t last_pos;
 
+    /** end of the data read without gaps from the start, the random
+     *  access points before it are all in the index         */
+    int64_t index_pos;
+    /** index_pos when the index file was loaded             */
+    int64_t index_file_pos;
+    /** a random access indicator was seen, the index holds key frames only */
+    int has_random_access;
+    char *index_file;
+
     /******************************************/
     /* private mpegts data */
     /* scan context */
@@ -144,6 +153,19 @@ static const AVClass mpegtsraw_class = {
     .version    = LIBAVUTIL_VERSION_INT,
 };
 
+static const AVOption mpegts_options[] = {
+    {"index_file", "load the key frame index from this file and save it there", offsetof(MpegTSContext, index_file), AV_OPT_TYPE_STRING,
+     {.str = NULL}, 0, 0, AV_OPT_FLAG_DECODING_PARAM },
+    { NULL },
+};
+
+static const AVClass mpegts_class = {
+    .class_name = "mpegts demuxer",
+    .item_name  = av_default_item_name,
+    .option     = mpegts_options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
 /* TS stream handling */
 
 enum MpegTSState {
@@ -176,6 +198,7 @@ typedef struct PESContext {
     int extended_stream_id;
     int64_t pts, dts;
     int64_t ts_packet_pos; /**< position of first TS packet of this PES packet */
+    int random_access; /**< random access indicator of the first TS packet */
     uint8_t header[MAX_PES_HEADER_SIZE];
     AVBufferRef *buffer;
     SLConfigDescr sl;
@@ -955,6 +978,15 @@ static int mpegts_push_data(MpegTSFilter *filter,
                     }
                 }
 
+                /* index the random access points, marked by the muxer
+                   for the key frames */
+                if (pes->random_access && pes->st && pes->dts != AV_NOPTS_VALUE) {
+                    pes->ts->has_random_access = 1;
+                    ff_reduce_index(pes->stream, pes->st->index);
+                    av_add_index_entry(pes->st, pes->ts_packet_pos, pes->dts,
+                                       0, 0, AVINDEX_KEYFRAME);
+                }
+
                 /* we got the full header. We parse it and get the payload */
                 pes->state = MPEGTS_PAYLOAD;
                 pes->data_index = 0;
@@ -1757,6 +1789,11 @@ static int handle_packet(MpegTSContext *ts, const uint8_t *packet)
     is_discontinuity = has_adaptation
                 && packet[4] != 0 /* with length > 0 */
                 && (packet[5] & 0x80); /* and discontinuity indicated */
+    if (is_start && tss->type == MPEGTS_PES) {
+        PESContext *pc = tss->u.pes_filter.opaque;
+        pc->random_access = has_adaptation && packet[4] != 0 &&
+                            (packet[5] & 0x40);
+    }
 
     /* continuity check (currently not used) */
     cc = (packet[3] & 0xf);
@@ -1882,8 +1919,9 @@ static int handle_packets(MpegTSContext *ts, int nb_packets)
     AVFormatContext *s = ts->stream;
     uint8_t packet[TS_PACKET_SIZE + FF_INPUT_BUFFER_PADDING_SIZE];
     int packet_num, ret = 0;
+    int64_t start_pos = avio_tell(s->pb);
 
-    if (avio_tell(s->pb) != ts->last_pos) {
+    if (start_pos != ts->last_pos) {
         int i;
         av_dlog(ts->stream, "Skipping after seek\n");
         /* seek detected, flush pes buffer */
@@ -1921,6 +1959,8 @@ static int handle_packets(MpegTSContext *ts, int nb_packets)
             break;
     }
     ts->last_pos = avio_tell(s->pb);
+    if (start_pos <= ts->index_pos)
+        ts->index_pos = FFMAX(ts->index_pos, ts->last_pos);
     return ret;
 }
 
@@ -1986,6 +2026,83 @@ static int parse_pcr(int64_t *ppcr_high, int *ppcr_low,
     return 0;
 }
 
+#define INDEX_FILE_TAG MKBETAG('T', 'S', 'I', 'X')
+
+/* The index file stores the size of the TS file it belongs to, index_pos,
+ * and for each stream its PID followed by the position and timestamp of its
+ * key frames. */
+static void load_index(AVFormatContext *s)
+{
+    MpegTSContext *ts = s->priv_data;
+    AVIOContext *pb;
+    int64_t index_pos;
+    int i, j, nb_streams;
+
+    if (avio_open2(&pb, ts->index_file, AVIO_FLAG_READ,
+                   &s->interrupt_callback, NULL) < 0)
+        return;
+
+    if (avio_rb32(pb) != INDEX_FILE_TAG || avio_rb64(pb) != avio_size(s->pb)) {
+        av_log(s, AV_LOG_WARNING, "Ignoring index file '%s' which does not "
+               "match the input\n", ts->index_file);
+        goto end;
+    }
+    index_pos  = avio_rb64(pb);
+    nb_streams = avio_rb32(pb);
+    for (i = 0; i < nb_streams && !url_feof(pb); i++) {
+        AVStream *st = NULL;
+        int id = avio_rb32(pb);
+        int nb_entries = avio_rb32(pb);
+
+        for (j = 0; j < s->nb_streams; j++)
+            if (s->streams[j]->id == id)
+                st = s->streams[j];
+        for (j = 0; j < nb_entries && !url_feof(pb); j++) {
+            int64_t pos       = avio_rb64(pb);
+            int64_t timestamp = avio_rb64(pb);
+            if (st)
+                av_add_index_entry(st, pos, timestamp, 0, 0, AVINDEX_KEYFRAME);
+        }
+    }
+    if (url_feof(pb)) {
+        av_log(s, AV_LOG_WARNING, "Index file '%s' is truncated\n",
+               ts->index_file);
+        goto end;
+    }
+    ts->index_pos = ts->index_file_pos = index_pos;
+    ts->has_random_access = 1;
+end:
+    avio_close(pb);
+}
+
+static void save_index(AVFormatContext *s)
+{
+    MpegTSContext *ts = s->priv_data;
+    AVIOContext *pb;
+    int i, j;
+
+    if (avio_open2(&pb, ts->index_file, AVIO_FLAG_WRITE,
+                   &s->interrupt_callback, NULL) < 0) {
+        av_log(s, AV_LOG_WARNING, "Could not write index file '%s'\n",
+               ts->index_file);
+        return;
+    }
+    avio_wb32(pb, INDEX_FILE_TAG);
+    avio_wb64(pb, avio_size(s->pb));
+    avio_wb64(pb, ts->index_pos);
+    avio_wb32(pb, s->nb_streams);
+    for (i = 0; i < s->nb_streams; i++) {
+        AVStream *st = s->streams[i];
+        avio_wb32(pb, st->id);
+        avio_wb32(pb, st->nb_index_entries);
+        for (j = 0; j < st->nb_index_entries; j++) {
+            avio_wb64(pb, st->index_entries[j].pos);
+            avio_wb64(pb, st->index_entries[j].timestamp);
+        }
+    }
+    avio_close(pb);
+}
+
 static int mpegts_read_header(AVFormatContext *s)
 {
     MpegTSContext *ts = s->priv_data;
@@ -2076,6 +2193,9 @@ static int mpegts_read_header(AVFormatContext *s)
     }
 
     avio_seek(pb, pos, SEEK_SET);
+    ts->index_pos = pos;
+    if (ts->index_file && pb->seekable)
+        load_index(s);
     return 0;
  fail:
     return -1;
@@ -2170,10 +2290,41 @@ static void mpegts_free(MpegTSContext *ts)
 static int mpegts_read_close(AVFormatContext *s)
 {
     MpegTSContext *ts = s->priv_data;
+
+    if (ts->index_file && ts->index_pos > ts->index_file_pos &&
+        s->pb && s->pb->seekable)
+        save_index(s);
     mpegts_free(ts);
     return 0;
 }
 
+/* Jump directly to a key frame of the index when the index covers the
+ * target, i.e. when the key frame following the target was indexed from
+ * data read without gaps or the whole file has been read. */
+static int mpegts_read_seek(AVFormatContext *s, int stream_index,
+                            int64_t timestamp, int flags)
+{
+    MpegTSContext *ts = s->priv_data;
+    AVStream *st = s->streams[stream_index];
+    AVIndexEntry *e;
+    int index, next;
+
+    index = av_index_search_timestamp(st, timestamp, flags);
+    if (index < 0)
+        return -1;
+    next = flags & AVSEEK_FLAG_BACKWARD ? index + 1 : index;
+    if (next < st->nb_index_entries ?
+        st->index_entries[next].pos >= ts->index_pos :
+        ts->index_pos < avio_size(s->pb))
+        return -1;
+
+    e = &st->index_entries[index];
+    if (avio_seek(s->pb, e->pos, SEEK_SET) < 0)
+        return -1;
+    ff_update_cur_dts(s, st, e->timestamp);
+    return 0;
+}
+
 static av_unused int64_t mpegts_get_pcr(AVFormatContext *s, int stream_index,
                               int64_t *ppos, int64_t pos_limit)
 {
@@ -2222,8 +2373,12 @@ static int64_t mpegts_get_dts(AVFormatContext *s, int stream_index,
             return AV_NOPTS_VALUE;
         av_free_packet(&pkt);
         if(pkt.dts != AV_NOPTS_VALUE && pkt.pos >= 0){
-            ff_reduce_index(s, pkt.stream_index);
-            av_add_index_entry(s->streams[pkt.stream_index], pkt.pos, pkt.dts, 0, 0, AVINDEX_KEYFRAME /* FIXME keyframe? */);
+            /* streams without random access indicators have no key frames
+               in the index, keep the positions found by the search instead */
+            if (!ts->has_random_access) {
+                ff_reduce_index(s, pkt.stream_index);
+                av_add_index_entry(s->streams[pkt.stream_index], pkt.pos, pkt.dts, 0, 0, AVINDEX_KEYFRAME /* FIXME keyframe? */);
+            }
             if(pkt.stream_index == stream_index){
                 *ppos= pkt.pos;
                 return pkt.dts;
@@ -2296,8 +2451,10 @@ AVInputFormat ff_mpegts_demuxer = {
     .read_header    = mpegts_read_header,
     .read_packet    = mpegts_read_packet,
     .read_close     = mpegts_read_close,
+    .read_seek      = mpegts_read_seek,
     .read_timestamp = mpegts_get_dts,
     .flags          = AVFMT_SHOW_IDS | AVFMT_TS_DISCONT,
+    .priv_class     = &mpegts_class,
 };
 
 AVInputFormat ff_mpegtsraw_demuxer = {
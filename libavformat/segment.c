@@ -30,6 +30,7 @@
 
 #include "avformat.h"
 #include "internal.h"
+#include "segwriter.h"
 
 #include "libavutil/avassert.h"
 #include "libavutil/log.h"
@@ -99,6 +100,9 @@ typedef struct {
     SegmentListEntry *segment_list_entries_end;
 
     int is_first_pkt;      ///< tells if it is the first packet in the segment
+
+    SegWriter *writer;     ///< closes the segments and updates the list in the background
+    int queue_size;        ///< maximum number of pending background writes
 } SegmentContext;
 
 static void print_csv_escaped_str(AVIOContext *ctx, const char *str)
@@ -157,9 +161,15 @@ static int set_segment_filename(AVFormatContext *s)
 {
     SegmentContext *seg = s->priv_data;
     AVFormatContext *oc = seg->avf;
+    int ret;
 
-    if (seg->segment_idx_wrap)
+    if (seg->segment_idx_wrap && seg->segment_idx >= seg->segment_idx_wrap) {
+        /* the names are reused from here on, let the segments still being
+         * closed in the background finish before one of them is truncated */
+        if ((ret = ff_segwriter_flush(seg->writer)) < 0)
+            return ret;
         seg->segment_idx %= seg->segment_idx_wrap;
+    }
     if (av_get_frame_filename(oc->filename, sizeof(oc->filename),
                               s->filename, seg->segment_idx) < 0) {
         av_log(oc, AV_LOG_ERROR, "Invalid segment filename template '%s'\n", s->filename);
@@ -204,32 +214,39 @@ static int segment_start(AVFormatContext *s, int write_header)
     return 0;
 }
 
-static int segment_list_open(AVFormatContext *s)
+static void segment_list_print_header(AVFormatContext *s, AVIOContext *pb)
 {
     SegmentContext *seg = s->priv_data;
-    int ret;
-
-    ret = avio_open2(&seg->list_pb, seg->list, AVIO_FLAG_WRITE,
-                     &s->interrupt_callback, NULL);
-    if (ret < 0)
-        return ret;
 
     if (seg->list_type == LIST_TYPE_M3U8 && seg->segment_list_entries) {
         SegmentListEntry *entry;
         double max_duration = 0;
 
-        avio_printf(seg->list_pb, "#EXTM3U\n");
-        avio_printf(seg->list_pb, "#EXT-X-VERSION:3\n");
-        avio_printf(seg->list_pb, "#EXT-X-MEDIA-SEQUENCE:%d\n", seg->segment_list_entries->index);
-        avio_printf(seg->list_pb, "#EXT-X-ALLOW-CACHE:%s\n",
+        avio_printf(pb, "#EXTM3U\n");
+        avio_printf(pb, "#EXT-X-VERSION:3\n");
+        avio_printf(pb, "#EXT-X-MEDIA-SEQUENCE:%d\n", seg->segment_list_entries->index);
+        avio_printf(pb, "#EXT-X-ALLOW-CACHE:%s\n",
                     seg->list_flags & SEGMENT_LIST_FLAG_CACHE ? "YES" : "NO");
 
         for (entry = seg->segment_list_entries; entry; entry = entry->next)
             max_duration = FFMAX(max_duration, entry->end_time - entry->start_time);
-        avio_printf(seg->list_pb, "#EXT-X-TARGETDURATION:%"PRId64"\n", (int64_t)ceil(max_duration));
+        avio_printf(pb, "#EXT-X-TARGETDURATION:%"PRId64"\n", (int64_t)ceil(max_duration));
     } else if (seg->list_type == LIST_TYPE_FFCONCAT) {
-        avio_printf(seg->list_pb, "ffconcat version 1.0\n");
+        avio_printf(pb, "ffconcat version 1.0\n");
     }
+}
+
+static int segment_list_open(AVFormatContext *s)
+{
+    SegmentContext *seg = s->priv_data;
+    int ret;
+
+    ret = avio_open2(&seg->list_pb, seg->list, AVIO_FLAG_WRITE,
+                     &s->interrupt_callback, NULL);
+    if (ret < 0)
+        return ret;
+
+    segment_list_print_header(s, seg->list_pb);
 
     return ret;
 }
@@ -273,7 +290,9 @@ static int segment_end(AVFormatContext *s, int write_trailer, int is_last)
 {
     SegmentContext *seg = s->priv_data;
     AVFormatContext *oc = seg->avf;
-    int ret = 0;
+    AVIOContext *pb;
+    uint8_t *buf;
+    int ret = 0, err, size;
 
     av_write_frame(oc, NULL); /* Flush any buffered data (fragmented mp4) */
     if (write_trailer)
@@ -283,12 +302,23 @@ static int segment_end(AVFormatContext *s, int write_trailer, int is_last)
         av_log(s, AV_LOG_ERROR, "Failure occurred when ending segment '%s'\n",
                oc->filename);
 
+    /* The segment is closed by the writer before the list is updated,
+     * so the list never references an incomplete segment. */
+    err = ff_segwriter_close(seg->writer, oc->pb);
+    oc->pb = NULL;
+    if (err < 0)
+        return err;
+
     if (seg->list) {
+        if ((err = avio_open_dyn_buf(&pb)) < 0)
+            return err;
+
         if (seg->list_size || seg->list_type == LIST_TYPE_M3U8) {
             SegmentListEntry *entry = av_mallocz(sizeof(*entry));
             if (!entry) {
-                ret = AVERROR(ENOMEM);
-                goto end;
+                avio_close_dyn_buf(pb, &buf);
+                av_free(buf);
+                return AVERROR(ENOMEM);
             }
 
             /* append new element */
@@ -306,23 +336,26 @@ static int segment_end(AVFormatContext *s, int write_trailer, int is_last)
                 av_freep(&entry);
             }
 
-            avio_close(seg->list_pb);
-            if ((ret = segment_list_open(s)) < 0)
-                goto end;
+            segment_list_print_header(s, pb);
             for (entry = seg->segment_list_entries; entry; entry = entry->next)
-                segment_list_print_entry(seg->list_pb, seg->list_type, entry, s);
+                segment_list_print_entry(pb, seg->list_type, entry, s);
             if (seg->list_type == LIST_TYPE_M3U8 && is_last)
-                avio_printf(seg->list_pb, "#EXT-X-ENDLIST\n");
+                avio_printf(pb, "#EXT-X-ENDLIST\n");
+            size = avio_close_dyn_buf(pb, &buf);
+
+            /* the list is rewritten from scratch */
+            ff_segwriter_close(seg->writer, seg->list_pb);
+            seg->list_pb = NULL;
+            err = ff_segwriter_write_file(seg->writer, seg->list, buf, size,
+                                          &s->interrupt_callback);
         } else {
-            segment_list_print_entry(seg->list_pb, seg->list_type, &seg->cur_entry, s);
+            segment_list_print_entry(pb, seg->list_type, &seg->cur_entry, s);
+            size = avio_close_dyn_buf(pb, &buf);
+            err = ff_segwriter_write(seg->writer, seg->list_pb, buf, size);
         }
-        avio_flush(seg->list_pb);
     }
 
-end:
-    avio_close(oc->pb);
-
-    return ret;
+    return ret < 0 ? ret : err;
 }
 
 static int parse_times(void *log_ctx, int64_t **times, int *nb_times,
@@ -596,6 +629,9 @@ static int seg_write_header(AVFormatContext *s)
         goto fail;
     }
 
+    if ((ret = ff_segwriter_alloc(&seg->writer, seg->queue_size, s)) < 0)
+        goto fail;
+
     if ((ret = segment_mux_init(s)) < 0)
         goto fail;
     oc = seg->avf;
@@ -631,6 +667,7 @@ static int seg_write_header(AVFormatContext *s)
 
 fail:
     if (ret) {
+        ff_segwriter_free(&seg->writer);
         if (seg->list)
             avio_close(seg->list_pb);
         if (seg->avf)
@@ -719,6 +756,7 @@ fail:
         seg->frame_count++;
 
     if (ret < 0) {
+        ff_segwriter_free(&seg->writer);
         if (seg->list)
             avio_close(seg->list_pb);
         avformat_free_context(oc);
@@ -733,7 +771,7 @@ static int seg_write_trailer(struct AVFormatContext *s)
     AVFormatContext *oc = seg->avf;
     SegmentListEntry *cur, *next;
 
-    int ret;
+    int ret, ret2;
     if (!seg->write_header_trailer) {
         if ((ret = segment_end(s, 0, 1)) < 0)
             goto fail;
@@ -744,6 +782,9 @@ static int seg_write_trailer(struct AVFormatContext *s)
         ret = segment_end(s, 1, 1);
     }
 fail:
+    ret2 = ff_segwriter_free(&seg->writer);
+    if (!ret)
+        ret = ret2;
     if (seg->list)
         avio_close(seg->list_pb);
 
@@ -793,6 +834,7 @@ static const AVOption options[] = {
     { "individual_header_trailer", "write header/trailer to each segment", OFFSET(individual_header_trailer), AV_OPT_TYPE_INT, {.i64 = 1}, 0, 1, E },
     { "write_header_trailer", "write a header to the first segment and a trailer to the last one", OFFSET(write_header_trailer), AV_OPT_TYPE_INT, {.i64 = 1}, 0, 1, E },
     { "reset_timestamps", "reset timestamps at the begin of each segment", OFFSET(reset_timestamps), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 1, E },
+    { "segment_queue_size", "set the number of segment and list writes done in the background, 0 to write synchronously", OFFSET(queue_size), AV_OPT_TYPE_INT, {.i64 = 4}, 0, INT_MAX, E },
     { NULL },
 };
 
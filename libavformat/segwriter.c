@@ -0,0 +1,253 @@
+/*
+ * Background writer for the segmenting muxers
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "libavutil/avstring.h"
+#include "libavutil/mem.h"
+#include "avformat.h"
+#include "segwriter.h"
+
+typedef struct SegWriterJob {
+    AVIOContext *pb;
+    char *url;                  ///< file to open for writing buf, if not NULL
+    AVIOInterruptCB int_cb;
+    uint8_t *buf;
+    int size;
+    int close;                  ///< close pb once done
+} SegWriterJob;
+
+struct SegWriter {
+    void *log_ctx;
+    int error;                  ///< first error returned by a job
+    int threaded;
+#if HAVE_PTHREADS
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    SegWriterJob *jobs;
+    int queue_size;
+    int first;                  ///< index of the job being run or next to run
+    int nb_jobs;                ///< number of queued jobs, including the running one
+    int exit;
+#endif
+};
+
+static int run_job(SegWriter *w, SegWriterJob *job)
+{
+    int ret = 0, ret2;
+
+    if (job->url) {
+        ret = avio_open2(&job->pb, job->url, AVIO_FLAG_WRITE, &job->int_cb, NULL);
+        if (ret < 0) {
+            av_log(w->log_ctx, AV_LOG_ERROR, "Failed to open '%s'\n", job->url);
+            goto end;
+        }
+        job->close = 1;
+    }
+    if (job->buf) {
+        avio_write(job->pb, job->buf, job->size);
+        avio_flush(job->pb);
+        ret = job->pb->error;
+    }
+    if (job->close) {
+        ret2 = avio_close(job->pb);
+        if (!ret)
+            ret = ret2;
+    }
+
+end:
+    av_free(job->url);
+    av_free(job->buf);
+    return ret;
+}
+
+#if HAVE_PTHREADS
+static void *segwriter_thread(void *arg)
+{
+    SegWriter *w = arg;
+    SegWriterJob job;
+    int ret;
+
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (!w->nb_jobs && !w->exit)
+            pthread_cond_wait(&w->cond, &w->lock);
+        if (!w->nb_jobs)
+            break;
+
+        job = w->jobs[w->first];
+        pthread_mutex_unlock(&w->lock);
+        ret = run_job(w, &job);
+        pthread_mutex_lock(&w->lock);
+
+        if (ret < 0 && !w->error)
+            w->error = ret;
+        w->first = (w->first + 1) % w->queue_size;
+        w->nb_jobs--;
+        pthread_cond_broadcast(&w->cond);
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    return NULL;
+}
+#endif
+
+int ff_segwriter_alloc(SegWriter **pw, int queue_size, void *log_ctx)
+{
+    SegWriter *w = av_mallocz(sizeof(*w));
+
+    if (!w)
+        return AVERROR(ENOMEM);
+    w->log_ctx = log_ctx;
+
+#if HAVE_PTHREADS
+    if (queue_size > 0) {
+        int ret;
+
+        w->jobs = av_malloc(queue_size * sizeof(*w->jobs));
+        if (!w->jobs) {
+            av_free(w);
+            return AVERROR(ENOMEM);
+        }
+        w->queue_size = queue_size;
+
+        pthread_mutex_init(&w->lock, NULL);
+        pthread_cond_init(&w->cond, NULL);
+        if ((ret = pthread_create(&w->thread, NULL, segwriter_thread, w))) {
+            av_log(log_ctx, AV_LOG_WARNING,
+                   "pthread_create failed: %s, writing synchronously\n",
+                   strerror(ret));
+            pthread_mutex_destroy(&w->lock);
+            pthread_cond_destroy(&w->cond);
+            av_freep(&w->jobs);
+        } else {
+            w->threaded = 1;
+        }
+    }
+#endif
+
+    *pw = w;
+    return 0;
+}
+
+static int queue_job(SegWriter *w, SegWriterJob *job)
+{
+    int ret = 0;
+
+    if (!w->threaded) {
+        ret = run_job(w, job);
+        if (ret < 0 && !w->error)
+            w->error = ret;
+        return w->error;
+    }
+
+#if HAVE_PTHREADS
+    pthread_mutex_lock(&w->lock);
+    while (w->nb_jobs == w->queue_size)
+        pthread_cond_wait(&w->cond, &w->lock);
+    w->jobs[(w->first + w->nb_jobs) % w->queue_size] = *job;
+    w->nb_jobs++;
+    pthread_cond_broadcast(&w->cond);
+    ret = w->error;
+    pthread_mutex_unlock(&w->lock);
+#endif
+
+    return ret;
+}
+
+int ff_segwriter_close(SegWriter *w, AVIOContext *pb)
+{
+    SegWriterJob job = { .pb = pb, .close = 1 };
+
+    if (!pb)
+        return w->error;
+    return queue_job(w, &job);
+}
+
+int ff_segwriter_write(SegWriter *w, AVIOContext *pb, uint8_t *buf, int size)
+{
+    SegWriterJob job = { .pb = pb, .buf = buf, .size = size };
+
+    return queue_job(w, &job);
+}
+
+int ff_segwriter_write_file(SegWriter *w, const char *url, uint8_t *buf,
+                            int size, const AVIOInterruptCB *int_cb)
+{
+    SegWriterJob job = { .buf = buf, .size = size };
+
+    if (!(job.url = av_strdup(url))) {
+        av_free(buf);
+        return AVERROR(ENOMEM);
+    }
+    if (int_cb)
+        job.int_cb = *int_cb;
+    return queue_job(w, &job);
+}
+
+int ff_segwriter_flush(SegWriter *w)
+{
+    int ret = 0;
+
+    if (!w->threaded)
+        return w->error;
+
+#if HAVE_PTHREADS
+    pthread_mutex_lock(&w->lock);
+    while (w->nb_jobs)
+        pthread_cond_wait(&w->cond, &w->lock);
+    ret = w->error;
+    pthread_mutex_unlock(&w->lock);
+#endif
+
+    return ret;
+}
+
+int ff_segwriter_free(SegWriter **pw)
+{
+    SegWriter *w = *pw;
+    int ret;
+
+    if (!w)
+        return 0;
+
+#if HAVE_PTHREADS
+    if (w->threaded) {
+        pthread_mutex_lock(&w->lock);
+        w->exit = 1;
+        pthread_cond_broadcast(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+        pthread_join(w->thread, NULL);
+
+        pthread_mutex_destroy(&w->lock);
+        pthread_cond_destroy(&w->cond);
+        av_freep(&w->jobs);
+    }
+#endif
+
+    ret = w->error;
+    av_freep(pw);
+    return ret;
+}
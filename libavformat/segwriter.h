@@ -0,0 +1,83 @@
+/*
+ * Background writer for the segmenting muxers
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_SEGWRITER_H
+#define AVFORMAT_SEGWRITER_H
+
+#include <stdint.h>
+
+#include "avio.h"
+
+/**
+ * Queue of I/O operations done in a background thread on behalf of a
+ * segmenting muxer, so that closing a finished segment or rewriting the
+ * playlist does not stall the muxing thread.
+ *
+ * The operations are run in the order they were queued. When the queue
+ * is full, queuing blocks until the oldest operation is done. An error
+ * returned by an operation is reported by the next call on the writer.
+ * Without thread support, or with a queue size of 0, the operations are
+ * run synchronously.
+ */
+typedef struct SegWriter SegWriter;
+
+/**
+ * Allocate a writer and start its thread.
+ *
+ * @param queue_size maximum number of pending operations
+ * @param log_ctx    context used for logging from the background thread
+ */
+int ff_segwriter_alloc(SegWriter **w, int queue_size, void *log_ctx);
+
+/**
+ * Queue flushing and closing pb. The writer takes ownership of pb.
+ */
+int ff_segwriter_close(SegWriter *w, AVIOContext *pb);
+
+/**
+ * Queue writing size bytes of buf to pb followed by a flush. The writer
+ * takes ownership of buf, which must have been allocated with av_malloc();
+ * pb must not be used by the caller until it is closed with
+ * ff_segwriter_close().
+ */
+int ff_segwriter_write(SegWriter *w, AVIOContext *pb, uint8_t *buf, int size);
+
+/**
+ * Queue replacing the content of url with size bytes of buf. The writer
+ * takes ownership of buf, which must have been allocated with av_malloc().
+ */
+int ff_segwriter_write_file(SegWriter *w, const char *url, uint8_t *buf,
+                            int size, const AVIOInterruptCB *int_cb);
+
+/**
+ * Wait for all the queued operations to be done.
+ *
+ * @return the first error returned by an operation, or 0
+ */
+int ff_segwriter_flush(SegWriter *w);
+
+/**
+ * Run the pending operations, stop the thread and free the writer.
+ *
+ * @return the first error returned by an operation, or 0
+ */
+int ff_segwriter_free(SegWriter **w);
+
+#endif /* AVFORMAT_SEGWRITER_H */
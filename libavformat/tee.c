@@ -20,17 +20,50 @@
  */
 
 
+#include "config.h"
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
 #include "libavutil/avutil.h"
 #include "libavutil/avstring.h"
+#include "libavutil/fifo.h"
 #include "libavutil/opt.h"
 #include "avformat.h"
+#include "url.h"
 
 #define MAX_SLAVES 16
+#define DEFAULT_QUEUE_SIZE 64
+
+enum OverflowPolicy {
+    ON_OVERFLOW_BLOCK,  ///< wait for the slave to catch up
+    ON_OVERFLOW_DROP,   ///< drop packets until the next key frame
+    ON_OVERFLOW_ABORT,  ///< stop writing to the slave
+};
+
+typedef struct TeeSlave {
+    AVFormatContext *avf;
+    int queue_size;             ///< maximum number of queued packets, 0 to write directly
+    enum OverflowPolicy on_overflow;
+    uint8_t *need_key;          ///< per stream, packets are dropped until a key frame
+    int64_t nb_dropped;
+    int aborted;                ///< the slave is not written to anymore
+    int error;                  ///< first error returned by the slave muxer
+#if HAVE_PTHREADS
+    AVIOInterruptCB tee_interrupt_cb;
+    AVFifoBuffer *queue;        ///< refcounted AVPackets
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int finished;               ///< no more packets will be queued
+#endif
+} TeeSlave;
 
 typedef struct TeeContext {
     const AVClass *class;
     unsigned nb_slaves;
-    AVFormatContext *slaves[MAX_SLAVES];
+    TeeSlave slaves[MAX_SLAVES];
 } TeeContext;
 
 static const char *const slave_delim     = "|";
@@ -82,7 +115,139 @@ fail:
     return ret;
 }
 
-static int open_slave(AVFormatContext *avf, char *slave, AVFormatContext **ravf)
+#if HAVE_PTHREADS
+static int slave_interrupt_cb(void *opaque)
+{
+    TeeSlave *tee_slave = opaque;
+    return tee_slave->aborted || ff_check_interrupt(&tee_slave->tee_interrupt_cb);
+}
+
+static void *slave_thread(void *arg)
+{
+    TeeSlave *tee_slave = arg;
+    AVPacket pkt;
+    int ret;
+
+    pthread_mutex_lock(&tee_slave->lock);
+    for (;;) {
+        while (!av_fifo_size(tee_slave->queue) &&
+               !tee_slave->finished && !tee_slave->aborted)
+            pthread_cond_wait(&tee_slave->cond, &tee_slave->lock);
+        if (tee_slave->aborted || !av_fifo_size(tee_slave->queue))
+            break;
+
+        av_fifo_generic_read(tee_slave->queue, &pkt, sizeof(pkt), NULL);
+        pthread_cond_signal(&tee_slave->cond);
+        if (tee_slave->error) {
+            /* keep draining the queue so that the caller is not blocked */
+            av_free_packet(&pkt);
+            continue;
+        }
+        pthread_mutex_unlock(&tee_slave->lock);
+
+        ret = av_interleaved_write_frame(tee_slave->avf, &pkt);
+        av_free_packet(&pkt);
+
+        pthread_mutex_lock(&tee_slave->lock);
+        if (ret < 0) {
+            tee_slave->error = ret;
+            pthread_cond_signal(&tee_slave->cond);
+        }
+    }
+    pthread_mutex_unlock(&tee_slave->lock);
+
+    return NULL;
+}
+
+static int start_slave_thread(AVFormatContext *avf, TeeSlave *tee_slave)
+{
+    int ret;
+
+    tee_slave->queue = av_fifo_alloc(tee_slave->queue_size * sizeof(AVPacket));
+    if (!tee_slave->queue)
+        return AVERROR(ENOMEM);
+
+    pthread_mutex_init(&tee_slave->lock, NULL);
+    pthread_cond_init(&tee_slave->cond, NULL);
+    if ((ret = pthread_create(&tee_slave->thread, NULL, slave_thread, tee_slave))) {
+        av_log(avf, AV_LOG_WARNING, "pthread_create failed: %s, "
+               "slave '%s' is written synchronously\n",
+               strerror(ret), tee_slave->avf->filename);
+        pthread_mutex_destroy(&tee_slave->lock);
+        pthread_cond_destroy(&tee_slave->cond);
+        av_fifo_free(tee_slave->queue);
+        tee_slave->queue = NULL;
+        tee_slave->queue_size = 0;
+    }
+    return 0;
+}
+
+/**
+ * Wait for the slave thread to write the queued packets and stop it.
+ */
+static void stop_slave_thread(TeeSlave *tee_slave)
+{
+    AVPacket pkt;
+
+    if (!tee_slave->queue)
+        return;
+
+    pthread_mutex_lock(&tee_slave->lock);
+    tee_slave->finished = 1;
+    pthread_cond_signal(&tee_slave->cond);
+    pthread_mutex_unlock(&tee_slave->lock);
+    pthread_join(tee_slave->thread, NULL);
+
+    /* left over by an aborted slave */
+    while (av_fifo_size(tee_slave->queue)) {
+        av_fifo_generic_read(tee_slave->queue, &pkt, sizeof(pkt), NULL);
+        av_free_packet(&pkt);
+    }
+    av_fifo_free(tee_slave->queue);
+    tee_slave->queue = NULL;
+    pthread_mutex_destroy(&tee_slave->lock);
+    pthread_cond_destroy(&tee_slave->cond);
+}
+#endif
+
+static int parse_slave_queue_options(AVFormatContext *avf, AVDictionary **options,
+                                     TeeSlave *tee_slave)
+{
+    AVDictionaryEntry *entry;
+    char *end;
+
+    tee_slave->queue_size  = DEFAULT_QUEUE_SIZE;
+    tee_slave->on_overflow = ON_OVERFLOW_BLOCK;
+
+    if ((entry = av_dict_get(*options, "queue_size", NULL, 0))) {
+        tee_slave->queue_size = strtol(entry->value, &end, 10);
+        if (*end || tee_slave->queue_size < 0) {
+            av_log(avf, AV_LOG_ERROR, "Invalid queue_size '%s'\n", entry->value);
+            return AVERROR(EINVAL);
+        }
+        av_dict_set(options, "queue_size", NULL, 0);
+    }
+    if ((entry = av_dict_get(*options, "onoverflow", NULL, 0))) {
+        if (!strcmp(entry->value, "block")) {
+            tee_slave->on_overflow = ON_OVERFLOW_BLOCK;
+        } else if (!strcmp(entry->value, "drop")) {
+            tee_slave->on_overflow = ON_OVERFLOW_DROP;
+        } else if (!strcmp(entry->value, "abort")) {
+            tee_slave->on_overflow = ON_OVERFLOW_ABORT;
+        } else {
+            av_log(avf, AV_LOG_ERROR, "Invalid onoverflow policy '%s'\n",
+                   entry->value);
+            return AVERROR(EINVAL);
+        }
+        av_dict_set(options, "onoverflow", NULL, 0);
+    }
+#if !HAVE_PTHREADS
+    tee_slave->queue_size = 0;
+#endif
+    return 0;
+}
+
+static int open_slave(AVFormatContext *avf, char *slave, TeeSlave *tee_slave)
 {
     int i, ret;
     AVDictionary *options = NULL;
@@ -99,11 +264,31 @@ static int open_slave(AVFormatContext *avf, char *slave, AVFormatContext **ravf)
         entry->value = NULL; /* prevent it from being freed */
         av_dict_set(&options, "f", NULL, 0);
     }
+    if ((ret = parse_slave_queue_options(avf, &options, tee_slave)) < 0) {
+        av_free(format);
+        goto fail;
+    }
 
     ret = avformat_alloc_output_context2(&avf2, NULL, format, filename);
     if (ret < 0)
         goto fail;
     av_free(format);
+    tee_slave->avf = avf2;
+
+    avf2->interrupt_callback = avf->interrupt_callback;
+#if HAVE_PTHREADS
+    /* an aborted slave must not stay blocked in its I/O */
+    if (tee_slave->queue_size) {
+        tee_slave->tee_interrupt_cb       = avf->interrupt_callback;
+        avf2->interrupt_callback.callback = slave_interrupt_cb;
+        avf2->interrupt_callback.opaque   = tee_slave;
+    }
+#endif
+
+    if (!(tee_slave->need_key = av_mallocz(avf->nb_streams))) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
 
     for (i = 0; i < avf->nb_streams; i++) {
         st = avf->streams[i];
@@ -126,7 +311,8 @@ static int open_slave(AVFormatContext *avf, char *slave, AVFormatContext **ravf)
     }
 
     if (!(avf2->oformat->flags & AVFMT_NOFILE)) {
-        if ((ret = avio_open(&avf2->pb, filename, AVIO_FLAG_WRITE)) < 0) {
+        if ((ret = avio_open2(&avf2->pb, filename, AVIO_FLAG_WRITE,
+                              &avf2->interrupt_callback, NULL)) < 0) {
             av_log(avf, AV_LOG_ERROR, "Slave '%s': error opening: %s\n",
                    slave, av_err2str(ret));
             goto fail;
@@ -146,7 +332,11 @@ static int open_slave(AVFormatContext *avf, char *slave, AVFormatContext **ravf)
         goto fail;
     }
 
-    *ravf = avf2;
+#if HAVE_PTHREADS
+    if (tee_slave->queue_size && (ret = start_slave_thread(avf, tee_slave)) < 0)
+        goto fail;
+#endif
+
     return 0;
 
 fail:
@@ -161,11 +351,17 @@ static void close_slaves(AVFormatContext *avf)
     unsigned i;
 
     for (i = 0; i < tee->nb_slaves; i++) {
-        avf2 = tee->slaves[i];
-        avio_close(avf2->pb);
-        avf2->pb = NULL;
-        avformat_free_context(avf2);
-        tee->slaves[i] = NULL;
+        avf2 = tee->slaves[i].avf;
+#if HAVE_PTHREADS
+        stop_slave_thread(&tee->slaves[i]);
+#endif
+        if (avf2) {
+            avio_close(avf2->pb);
+            avf2->pb = NULL;
+            avformat_free_context(avf2);
+        }
+        av_freep(&tee->slaves[i].need_key);
+        tee->slaves[i].avf = NULL;
     }
 }
 
@@ -193,12 +389,12 @@ static int tee_write_header(AVFormatContext *avf)
     }
 
     for (i = 0; i < nb_slaves; i++) {
+        tee->nb_slaves = i + 1;
         if ((ret = open_slave(avf, slaves[i], &tee->slaves[i])) < 0)
             goto fail;
         av_freep(&slaves[i]);
     }
 
-    tee->nb_slaves = nb_slaves;
     return 0;
 
 fail:
@@ -211,12 +407,28 @@ fail:
 static int tee_write_trailer(AVFormatContext *avf)
 {
     TeeContext *tee = avf->priv_data;
+    TeeSlave *tee_slave;
     AVFormatContext *avf2;
     int ret_all = 0, ret;
     unsigned i;
 
     for (i = 0; i < tee->nb_slaves; i++) {
-        avf2 = tee->slaves[i];
+        tee_slave = &tee->slaves[i];
+        avf2 = tee_slave->avf;
+#if HAVE_PTHREADS
+        stop_slave_thread(tee_slave);
+#endif
+        if (tee_slave->nb_dropped)
+            av_log(avf, AV_LOG_WARNING, "Slave '%s': %"PRId64" packets dropped\n",
+                   avf2->filename, tee_slave->nb_dropped);
+        if (tee_slave->error && !ret_all)
+            ret_all = tee_slave->error;
+        if (tee_slave->aborted) {
+            /* the slave output is most likely stuck */
+            avio_close(avf2->pb);
+            avf2->pb = NULL;
+            continue;
+        }
         if ((ret = av_write_trailer(avf2)) < 0)
             if (!ret_all)
                 ret_all = ret;
@@ -231,38 +443,109 @@ static int tee_write_trailer(AVFormatContext *avf)
     return ret_all;
 }
 
+#if HAVE_PTHREADS
+/**
+ * Queue a packet for the slave thread, applying the overflow policy of
+ * the slave when the queue is full.
+ */
+static int queue_slave_packet(AVFormatContext *avf, TeeSlave *tee_slave,
+                              AVPacket *pkt)
+{
+    int ret;
+
+    pthread_mutex_lock(&tee_slave->lock);
+    if (tee_slave->on_overflow == ON_OVERFLOW_BLOCK) {
+        while (av_fifo_space(tee_slave->queue) < sizeof(*pkt) &&
+               !tee_slave->error) {
+            if (ff_check_interrupt(&avf->interrupt_callback)) {
+                pthread_mutex_unlock(&tee_slave->lock);
+                av_free_packet(pkt);
+                return AVERROR_EXIT;
+            }
+            pthread_cond_wait(&tee_slave->cond, &tee_slave->lock);
+        }
+    }
+    if ((ret = tee_slave->error) < 0) {
+        av_free_packet(pkt);
+    } else if (av_fifo_space(tee_slave->queue) < sizeof(*pkt)) {
+        if (tee_slave->on_overflow == ON_OVERFLOW_ABORT) {
+            av_log(avf, AV_LOG_ERROR, "Slave '%s': queue full, aborting it\n",
+                   tee_slave->avf->filename);
+            tee_slave->aborted = 1;
+        } else {
+            tee_slave->need_key[pkt->stream_index] = 1;
+            tee_slave->nb_dropped++;
+        }
+        av_free_packet(pkt);
+    } else {
+        av_fifo_generic_write(tee_slave->queue, pkt, sizeof(*pkt), NULL);
+    }
+    pthread_cond_signal(&tee_slave->cond);
+    pthread_mutex_unlock(&tee_slave->lock);
+
+    return ret;
+}
+#endif
+
 static int tee_write_packet(AVFormatContext *avf, AVPacket *pkt)
 {
     TeeContext *tee = avf->priv_data;
+    TeeSlave *tee_slave;
     AVFormatContext *avf2;
-    AVPacket pkt2;
+    AVPacket pkt_ref = { 0 }, pkt2;
     int ret_all = 0, ret;
     unsigned i, s;
     AVRational tb, tb2;
 
+    /* the slaves share the same data, copied at most once */
+    if (!pkt->buf) {
+        if ((ret = av_copy_packet(&pkt_ref, pkt)) < 0)
+            return ret;
+        pkt = &pkt_ref;
+    }
+
     for (i = 0; i < tee->nb_slaves; i++) {
-        avf2 = tee->slaves[i];
+        tee_slave = &tee->slaves[i];
+        avf2 = tee_slave->avf;
         s = pkt->stream_index;
+        if (tee_slave->aborted)
+            continue;
         if (s >= avf2->nb_streams) {
             if (!ret_all)
                 ret_all = AVERROR(EINVAL);
             continue;
         }
-        if ((ret = av_copy_packet(&pkt2, pkt)) < 0 ||
-            (ret = av_dup_packet(&pkt2))< 0)
-            if (!ret_all) {
-                ret = ret_all;
+        if (tee_slave->need_key[s]) {
+            if (!(pkt->flags & AV_PKT_FLAG_KEY)) {
+                tee_slave->nb_dropped++;
                 continue;
             }
+            tee_slave->need_key[s] = 0;
+        }
+        if ((ret = av_copy_packet(&pkt2, pkt)) < 0) {
+            if (!ret_all)
+                ret_all = ret;
+            continue;
+        }
         tb  = avf ->streams[s]->time_base;
         tb2 = avf2->streams[s]->time_base;
         pkt2.pts      = av_rescale_q(pkt->pts,      tb, tb2);
         pkt2.dts      = av_rescale_q(pkt->dts,      tb, tb2);
         pkt2.duration = av_rescale_q(pkt->duration, tb, tb2);
-        if ((ret = av_interleaved_write_frame(avf2, &pkt2)) < 0)
-            if (!ret_all)
-                ret_all = ret;
+#if HAVE_PTHREADS
+        if (tee_slave->queue) {
+            ret = queue_slave_packet(avf, tee_slave, &pkt2);
+        } else
+#endif
+        {
+            ret = av_interleaved_write_frame(avf2, &pkt2);
+            av_free_packet(&pkt2);
+        }
+        if (ret < 0 && !ret_all)
+            ret_all = ret;
     }
+
+    av_free_packet(&pkt_ref);
     return ret_all;
 }
 
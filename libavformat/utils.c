@@ -44,6 +44,9 @@
 #if CONFIG_NETWORK
 #include "network.h"
 #endif
+#if CONFIG_HTTP_PROTOCOL
+#include "http.h"
+#endif
 
 #undef NDEBUG
 #include <assert.h>
@@ -2765,6 +2768,7 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
     int64_t old_offset = avio_tell(ic->pb);
     int orig_nb_streams = ic->nb_streams;        // new streams might appear, no options for those
     int flush_codecs = ic->probesize > 0;
+    int fast_info = ic->flags & AVFMT_FLAG_FAST_INFO;
 
     if(ic->pb)
         av_log(ic, AV_LOG_DEBUG, "File position before avformat_find_stream_info() is %"PRId64"\n", avio_tell(ic->pb));
@@ -2841,6 +2845,9 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
             int fps_analyze_framecount = 20;
 
             st = ic->streams[i];
+            /* in fast mode, the streams the caller discards are not analyzed */
+            if (fast_info && st->discard >= AVDISCARD_ALL)
+                continue;
             if (!has_codec_parameters(st, NULL))
                 break;
             /* if the timebase is coarse (like the usual millisecond precision
@@ -2852,8 +2859,10 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
                 fps_analyze_framecount = ic->fps_probe_size;
             if (st->disposition & AV_DISPOSITION_ATTACHED_PIC)
                 fps_analyze_framecount = 0;
-            /* variable fps and no guess at the real fps */
-            if(   tb_unreliable(st->codec) && !(st->r_frame_rate.num && st->avg_frame_rate.num)
+            /* variable fps and no guess at the real fps; in fast mode the
+               frame rate is only estimated from the frames read anyway */
+            if(   !fast_info
+               && tb_unreliable(st->codec) && !(st->r_frame_rate.num && st->avg_frame_rate.num)
                && st->info->duration_count < fps_analyze_framecount
                && st->codec->codec_type == AVMEDIA_TYPE_VIDEO)
                 break;
@@ -2867,8 +2876,9 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
         if (i == ic->nb_streams) {
             /* NOTE: if the format has no header, then we need to read
                some packets to get most of the streams, so we cannot
-               stop here */
-            if (!(ic->ctx_flags & AVFMTCTX_NOHEADER)) {
+               stop here, unless the caller prefers a fast start to
+               knowing about streams which appear later */
+            if (!(ic->ctx_flags & AVFMTCTX_NOHEADER) || (fast_info && count)) {
                 /* if we found the info for all the codecs, we can stop */
                 ret = count;
                 av_log(ic, AV_LOG_DEBUG, "All info found\n");
@@ -3014,7 +3024,8 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
            least one frame of codec data, this makes sure the codec initializes
            the channel configuration and does not only trust the values from the container.
         */
-        try_decode_frame(st, pkt, (options && i < orig_nb_streams ) ? &options[i] : NULL);
+        if (!fast_info || st->discard < AVDISCARD_ALL)
+            try_decode_frame(st, pkt, (options && i < orig_nb_streams ) ? &options[i] : NULL);
 
         st->codec_info_nb_frames++;
         count++;
@@ -3030,6 +3041,8 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
             const char *errmsg;
 
             st = ic->streams[i];
+            if (fast_info && st->discard >= AVDISCARD_ALL)
+                continue;
 
             /* flush the decoders */
             if (st->info->found_decoder == 1) {
@@ -4219,6 +4232,9 @@ int avformat_network_init(void)
 int avformat_network_deinit(void)
 {
 #if CONFIG_NETWORK
+#if CONFIG_HTTP_PROTOCOL
+    ff_http_close_pool();
+#endif
     ff_network_close();
     ff_tls_deinit();
 #endif
@@ -25,11 +25,18 @@
 #include "libavutil/samplefmt.h"
 #include "libavresample/audio_convert.h"
 
+void ff_conv_s16_to_flt_neon(float *dst, const int16_t *src, int len);
 void ff_conv_flt_to_s16_neon(int16_t *dst, const float *src, int len);
 void ff_conv_fltp_to_s16_neon(int16_t *dst, float *const *src,
                               int len, int channels);
 void ff_conv_fltp_to_s16_2ch_neon(int16_t *dst, float *const *src,
                                   int len, int channels);
+void ff_conv_fltp_to_flt_2ch_neon(float *dst, float *const *src, int len,
+                                  int channels);
+void ff_conv_flt_to_fltp_2ch_neon(float *const *dst, float *src, int len,
+                                  int channels);
+void ff_conv_s16_to_fltp_2ch_neon(float *const *dst, int16_t *src, int len,
+                                  int channels);
 
 av_cold void ff_audio_convert_init_arm(AudioConvert *ac)
 {
@@ -45,5 +52,17 @@ av_cold void ff_audio_convert_init_arm(AudioConvert *ac)
         ff_audio_convert_set_func(ac, AV_SAMPLE_FMT_S16, AV_SAMPLE_FMT_FLTP,
                                   2, 16, 8, "NEON",
                                   ff_conv_fltp_to_s16_2ch_neon);
+        ff_audio_convert_set_func(ac, AV_SAMPLE_FMT_FLT, AV_SAMPLE_FMT_S16,
+                                  0, 16, 8, "NEON",
+                                  ff_conv_s16_to_flt_neon);
+        ff_audio_convert_set_func(ac, AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_S16,
+                                  2, 16, 8, "NEON",
+                                  ff_conv_s16_to_fltp_2ch_neon);
+        ff_audio_convert_set_func(ac, AV_SAMPLE_FMT_FLT, AV_SAMPLE_FMT_FLTP,
+                                  2, 16, 8, "NEON",
+                                  ff_conv_fltp_to_flt_2ch_neon);
+        ff_audio_convert_set_func(ac, AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_FLT,
+                                  2, 16, 8, "NEON",
+                                  ff_conv_flt_to_fltp_2ch_neon);
     }
 }
@@ -0,0 +1,52 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/arm/cpu.h"
+#include "libavresample/audio_mix.h"
+
+void ff_mix_2_to_1_fltp_flt_neon(float **src, float **matrix, int len,
+                                 int out_ch, int in_ch);
+void ff_mix_2_to_1_s16p_flt_neon(int16_t **src, float **matrix, int len,
+                                 int out_ch, int in_ch);
+void ff_mix_2_to_1_s16p_q8_neon(int16_t **src, int16_t **matrix, int len,
+                                int out_ch, int in_ch);
+void ff_mix_6_to_2_fltp_flt_neon(float **src, float **matrix, int len,
+                                 int out_ch, int in_ch);
+void ff_mix_any_fltp_flt_neon(float **src, float **matrix, int len,
+                              int out_ch, int in_ch);
+
+av_cold void ff_audio_mix_init_arm(AudioMix *am)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (have_neon(cpu_flags)) {
+        ff_audio_mix_set_func(am, AV_SAMPLE_FMT_FLTP, AV_MIX_COEFF_TYPE_FLT,
+                              0, 0, 16, 4, "NEON", ff_mix_any_fltp_flt_neon);
+        ff_audio_mix_set_func(am, AV_SAMPLE_FMT_FLTP, AV_MIX_COEFF_TYPE_FLT,
+                              2, 1, 16, 8, "NEON", ff_mix_2_to_1_fltp_flt_neon);
+        ff_audio_mix_set_func(am, AV_SAMPLE_FMT_S16P, AV_MIX_COEFF_TYPE_FLT,
+                              2, 1, 16, 8, "NEON", ff_mix_2_to_1_s16p_flt_neon);
+        ff_audio_mix_set_func(am, AV_SAMPLE_FMT_S16P, AV_MIX_COEFF_TYPE_Q8,
+                              2, 1, 16, 8, "NEON", ff_mix_2_to_1_s16p_q8_neon);
+        ff_audio_mix_set_func(am, AV_SAMPLE_FMT_FLTP, AV_MIX_COEFF_TYPE_FLT,
+                              6, 2, 16, 4, "NEON", ff_mix_6_to_2_fltp_flt_neon);
+    }
+}
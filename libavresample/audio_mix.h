@@ -89,6 +89,7 @@ int ff_audio_mix_set_matrix(AudioMix *am, const double *matrix, int stride);
 
 /* arch-specific initialization functions */
 
+void ff_audio_mix_init_arm(AudioMix *am);
 void ff_audio_mix_init_x86(AudioMix *am);
 
 #endif /* AVRESAMPLE_AUDIO_MIX_H */
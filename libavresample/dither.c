@@ -338,6 +338,8 @@ static av_cold void dither_init(DitherDSPContext *ddsp,
     else
         ddsp->dither_int_to_float = dither_int_to_float_triangular_c;
 
+    if (ARCH_ARM)
+        ff_dither_init_arm(ddsp, method);
     if (ARCH_X86)
         ff_dither_init_x86(ddsp, method);
 }
@@ -87,6 +87,8 @@ int ff_convert_dither(DitherContext *c, AudioData *dst, AudioData *src);
 
 /* arch-specific initialization functions */
 
+void ff_dither_init_arm(DitherDSPContext *ddsp,
+                        enum AVResampleDitherMethod method);
 void ff_dither_init_x86(DitherDSPContext *ddsp,
                         enum AVResampleDitherMethod method);
 
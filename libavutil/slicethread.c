@@ -0,0 +1,218 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "common.h"
+#include "cpu.h"
+#include "error.h"
+#include "mem.h"
+#include "slicethread.h"
+
+#if HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS2THREADS
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#elif HAVE_W32THREADS
+#include "libavcodec/w32pthreads.h"
+#elif HAVE_OS2THREADS
+#include "libavcodec/os2threads.h"
+#endif
+
+/* Limit the number of automatically spawned threads, like the codec slice
+ * threading code does */
+#define MAX_AUTO_THREADS 16
+
+struct AVSliceThread {
+    pthread_t *workers;
+    int nb_threads;
+
+    void *priv;
+    void (*worker_func)(void *priv, int jobnr, int threadnr,
+                        int nb_jobs, int nb_threads);
+
+    pthread_cond_t  last_job_cond;
+    pthread_cond_t  current_job_cond;
+    pthread_mutex_t current_job_lock;
+    int current_job;
+    int nb_jobs;
+    unsigned int current_execute;
+    int done;
+};
+
+static void *attribute_align_arg worker(void *v)
+{
+    AVSliceThread *c = v;
+    int our_job      = c->nb_jobs;
+    int nb_threads   = c->nb_threads;
+    unsigned int last_execute = 0;
+    int self_id;
+
+    pthread_mutex_lock(&c->current_job_lock);
+    self_id = c->current_job++;
+    for (;;) {
+        while (our_job >= c->nb_jobs) {
+            if (c->current_job == nb_threads + c->nb_jobs)
+                pthread_cond_signal(&c->last_job_cond);
+
+            while (last_execute == c->current_execute && !c->done)
+                pthread_cond_wait(&c->current_job_cond, &c->current_job_lock);
+            last_execute = c->current_execute;
+            our_job      = self_id;
+
+            if (c->done) {
+                pthread_mutex_unlock(&c->current_job_lock);
+                return NULL;
+            }
+        }
+        pthread_mutex_unlock(&c->current_job_lock);
+
+        c->worker_func(c->priv, our_job, self_id, c->nb_jobs, nb_threads);
+
+        pthread_mutex_lock(&c->current_job_lock);
+        our_job = c->current_job++;
+    }
+}
+
+static void park_workers(AVSliceThread *c)
+{
+    while (c->current_job != c->nb_threads + c->nb_jobs)
+        pthread_cond_wait(&c->last_job_cond, &c->current_job_lock);
+    pthread_mutex_unlock(&c->current_job_lock);
+}
+
+static void stop_workers(AVSliceThread *c)
+{
+    int i;
+
+    pthread_mutex_lock(&c->current_job_lock);
+    c->done = 1;
+    pthread_cond_broadcast(&c->current_job_cond);
+    pthread_mutex_unlock(&c->current_job_lock);
+
+    for (i = 0; i < c->nb_threads; i++)
+        pthread_join(c->workers[i], NULL);
+
+    pthread_mutex_destroy(&c->current_job_lock);
+    pthread_cond_destroy(&c->current_job_cond);
+    pthread_cond_destroy(&c->last_job_cond);
+}
+
+int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
+                              void (*worker_func)(void *priv, int jobnr, int threadnr,
+                                                  int nb_jobs, int nb_threads),
+                              int nb_threads)
+{
+    AVSliceThread *c;
+    int i, ret;
+
+    *pctx = NULL;
+
+#if HAVE_W32THREADS
+    w32thread_init();
+#endif
+
+    if (!nb_threads) {
+        int nb_cpus = av_cpu_count();
+        // use number of cores + 1 as thread count if there is more than one
+        nb_threads = nb_cpus > 1 ? FFMIN(nb_cpus + 1, MAX_AUTO_THREADS) : 1;
+    }
+    if (nb_threads <= 1)
+        return AVERROR(ENOSYS);
+
+    c = av_mallocz(sizeof(*c));
+    if (!c)
+        return AVERROR(ENOMEM);
+    c->workers = av_mallocz(nb_threads * sizeof(*c->workers));
+    if (!c->workers) {
+        av_free(c);
+        return AVERROR(ENOMEM);
+    }
+
+    c->priv        = priv;
+    c->worker_func = worker_func;
+    c->nb_threads  = nb_threads;
+
+    pthread_cond_init(&c->current_job_cond, NULL);
+    pthread_cond_init(&c->last_job_cond,    NULL);
+    pthread_mutex_init(&c->current_job_lock, NULL);
+
+    pthread_mutex_lock(&c->current_job_lock);
+    for (i = 0; i < nb_threads; i++) {
+        ret = pthread_create(&c->workers[i], NULL, worker, c);
+        if (ret) {
+            pthread_mutex_unlock(&c->current_job_lock);
+            c->nb_threads = i;
+            stop_workers(c);
+            av_freep(&c->workers);
+            av_free(c);
+            return AVERROR(ret);
+        }
+    }
+    park_workers(c);
+
+    *pctx = c;
+    return nb_threads;
+}
+
+void avpriv_slicethread_execute(AVSliceThread *c, int nb_jobs)
+{
+    if (nb_jobs <= 0)
+        return;
+
+    pthread_mutex_lock(&c->current_job_lock);
+    c->current_job = c->nb_threads;
+    c->nb_jobs     = nb_jobs;
+    c->current_execute++;
+    pthread_cond_broadcast(&c->current_job_cond);
+    park_workers(c);
+}
+
+void avpriv_slicethread_free(AVSliceThread **pctx)
+{
+    AVSliceThread *c = *pctx;
+
+    if (!c)
+        return;
+
+    stop_workers(c);
+    av_freep(&c->workers);
+    av_freep(pctx);
+}
+
+#else /* HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS2THREADS */
+
+int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
+                              void (*worker_func)(void *priv, int jobnr, int threadnr,
+                                                  int nb_jobs, int nb_threads),
+                              int nb_threads)
+{
+    *pctx = NULL;
+    return AVERROR(ENOSYS);
+}
+
+void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs)
+{
+}
+
+void avpriv_slicethread_free(AVSliceThread **pctx)
+{
+    *pctx = NULL;
+}
+
+#endif /* HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS2THREADS */
@@ -0,0 +1,52 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_SLICETHREAD_H
+#define AVUTIL_SLICETHREAD_H
+
+typedef struct AVSliceThread AVSliceThread;
+
+/**
+ * Create a pool of worker threads executing jobs on behalf of the caller.
+ *
+ * @param pctx        pointer to the new context, set to NULL on failure
+ * @param priv        opaque pointer passed to worker_func
+ * @param worker_func function run for every job; jobnr is the index of the
+ *                    job, threadnr the index of the thread running it
+ * @param nb_threads  number of threads, 0 for automatic
+ * @return the number of threads (> 1) on success,
+ *         a negative AVERROR on failure,
+ *         AVERROR(ENOSYS) if threads are not available or only one thread
+ *         would be used, in which case the caller should run the jobs itself
+ */
+int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
+                              void (*worker_func)(void *priv, int jobnr, int threadnr,
+                                                  int nb_jobs, int nb_threads),
+                              int nb_threads);
+
+/**
+ * Run nb_jobs jobs on the pool and wait until all of them have finished.
+ */
+void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs);
+
+/**
+ * Stop and join all threads and free the context.
+ */
+void avpriv_slicethread_free(AVSliceThread **pctx);
+
+#endif /* AVUTIL_SLICETHREAD_H */
@@ -0,0 +1,63 @@
+/*
+ * This file is part of libswresample.
+ *
+ * libswresample is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libswresample is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libswresample; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/channel_layout.h"
+#include "libavutil/cpu.h"
+#include "libavutil/arm/cpu.h"
+#include "libavutil/mem.h"
+#include "libswresample/swresample_internal.h"
+
+mix_1_1_func_type swri_mix_1_1_int16_neon;
+mix_2_1_func_type swri_mix_2_1_int16_neon;
+mix_1_1_func_type swri_mix_1_1_float_neon;
+mix_2_1_func_type swri_mix_2_1_float_neon;
+
+av_cold void swri_rematrix_init_arm(struct SwrContext *s)
+{
+    int cpu_flags = av_get_cpu_flags();
+    int nb_in  = av_get_channel_layout_nb_channels(s->in_ch_layout);
+    int nb_out = av_get_channel_layout_nb_channels(s->out_ch_layout);
+    int num    = nb_in * nb_out;
+
+    s->mix_1_1_simd = NULL;
+    s->mix_2_1_simd = NULL;
+
+    if (!have_neon(cpu_flags))
+        return;
+
+    /* the NEON functions use the same coefficients as the C ones */
+    if (s->midbuf.fmt == AV_SAMPLE_FMT_S16P) {
+        s->native_simd_matrix = av_malloc(num * sizeof(int));
+        if (!s->native_simd_matrix)
+            return;
+        memcpy(s->native_simd_matrix, s->native_matrix, num * sizeof(int));
+        s->mix_1_1_simd = swri_mix_1_1_int16_neon;
+        s->mix_2_1_simd = swri_mix_2_1_int16_neon;
+    } else if (s->midbuf.fmt == AV_SAMPLE_FMT_FLTP) {
+        s->native_simd_matrix = av_malloc(num * sizeof(float));
+        if (!s->native_simd_matrix)
+            return;
+        memcpy(s->native_simd_matrix, s->native_matrix, num * sizeof(float));
+        s->mix_1_1_simd = swri_mix_1_1_float_neon;
+        s->mix_2_1_simd = swri_mix_2_1_float_neon;
+    }
+}
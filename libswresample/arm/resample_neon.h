@@ -0,0 +1,51 @@
+/*
+ * audio resampling, NEON optimized
+ *
+ * This file is part of libswresample.
+ *
+ * libswresample is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libswresample is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libswresample; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+
+#include "libavutil/cpu.h"
+#include "libswresample/swresample_internal.h"
+
+int swri_resample_int16_neon (struct ResampleContext *c, int16_t *dst, const int16_t *src, int *consumed, int src_size, int dst_size, int update_ctx);
+int swri_resample_int32_neon (struct ResampleContext *c, int32_t *dst, const int32_t *src, int *consumed, int src_size, int dst_size, int update_ctx);
+int swri_resample_float_neon (struct ResampleContext *c, float   *dst, const float   *src, int *consumed, int src_size, int dst_size, int update_ctx);
+int swri_resample_double_neon(struct ResampleContext *c, double  *dst, const double  *src, int *consumed, int src_size, int dst_size, int update_ctx);
+
+/* Sum of src[i] * filter[i] for i < len, accumulated in FELEM2 like the C code. */
+int     swri_resample_dot_int16_neon (const int16_t *src, const int16_t *filter, int len);
+int64_t swri_resample_dot_int32_neon (const int32_t *src, const int32_t *filter, int len);
+float   swri_resample_dot_float_neon (const float   *src, const float   *filter, int len);
+double  swri_resample_dot_double_neon(const double  *src, const double  *filter, int len);
+
+/* Same as above for filter and for the next phase filter, which follows it
+ * FFALIGN(len, 8) elements later; the two sums are stored in val[0..1]. */
+void swri_resample_linear_int16_neon (int32_t val[2], const int16_t *src, const int16_t *filter, int len);
+void swri_resample_linear_int32_neon (int64_t val[2], const int32_t *src, const int32_t *filter, int len);
+void swri_resample_linear_float_neon (float   val[2], const float   *src, const float   *filter, int len);
+void swri_resample_linear_double_neon(double  val[2], const double  *src, const double  *filter, int len);
+
+#define COMMON_CORE_NEON(type) \
+    FELEM2 val = swri_resample_dot_ ## type ## _neon(src + sample_index, filter, c->filter_length);\
+    OUT(dst[dst_index], val);
+
+#define LINEAR_CORE_NEON(type) \
+    FELEM2 v[2];\
+    swri_resample_linear_ ## type ## _neon(v, src + sample_index, filter, c->filter_length);\
+    val = v[0] + (v[1] - v[0]) * (FELEML)frac / c->src_incr;
@@ -380,6 +380,7 @@ av_cold int swri_rematrix_init(SwrContext *s){
     }
 
     if(HAVE_YASM && HAVE_MMX) swri_rematrix_init_x86(s);
+    if(ARCH_ARM)              swri_rematrix_init_arm(s);
 
     return 0;
 }
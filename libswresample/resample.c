@@ -310,6 +310,28 @@ static int set_compensation(ResampleContext *c, int sample_delta, int compensati
 
 #endif // HAVE_MMXEXT_INLINE
 
+#if HAVE_NEON
+
+#include "arm/resample_neon.h"
+
+#define TEMPLATE_RESAMPLE_S16_NEON
+#include "resample_template.c"
+#undef TEMPLATE_RESAMPLE_S16_NEON
+
+#define TEMPLATE_RESAMPLE_S32_NEON
+#include "resample_template.c"
+#undef TEMPLATE_RESAMPLE_S32_NEON
+
+#define TEMPLATE_RESAMPLE_FLT_NEON
+#include "resample_template.c"
+#undef TEMPLATE_RESAMPLE_FLT_NEON
+
+#define TEMPLATE_RESAMPLE_DBL_NEON
+#include "resample_template.c"
+#undef TEMPLATE_RESAMPLE_DBL_NEON
+
+#endif // HAVE_NEON
+
 static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, AudioData *src, int src_size, int *consumed){
     int i, ret= -1;
     int av_unused mm_flags = av_get_cpu_flags();
@@ -325,6 +347,13 @@ static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, A
                  ret= swri_resample_int16_mmx2 (c, (int16_t*)dst->ch[i], (const int16_t*)src->ch[i], consumed, src_size, dst_size, i+1==dst->ch_count);
                  need_emms= 1;
              } else
+#endif
+#if HAVE_NEON
+             if(c->format == AV_SAMPLE_FMT_S16P && (mm_flags&AV_CPU_FLAG_NEON)) ret= swri_resample_int16_neon (c, (int16_t*)dst->ch[i], (const int16_t*)src->ch[i], consumed, src_size, dst_size, i+1==dst->ch_count);
+        else if(c->format == AV_SAMPLE_FMT_S32P && (mm_flags&AV_CPU_FLAG_NEON)) ret= swri_resample_int32_neon (c, (int32_t*)dst->ch[i], (const int32_t*)src->ch[i], consumed, src_size, dst_size, i+1==dst->ch_count);
+        else if(c->format == AV_SAMPLE_FMT_FLTP && (mm_flags&AV_CPU_FLAG_NEON)) ret= swri_resample_float_neon (c, (float  *)dst->ch[i], (const float  *)src->ch[i], consumed, src_size, dst_size, i+1==dst->ch_count);
+        else if(c->format == AV_SAMPLE_FMT_DBLP && (mm_flags&AV_CPU_FLAG_NEON)) ret= swri_resample_double_neon(c, (double *)dst->ch[i], (const double *)src->ch[i], consumed, src_size, dst_size, i+1==dst->ch_count);
+        else
 #endif
              if(c->format == AV_SAMPLE_FMT_S16P) ret= swri_resample_int16(c, (int16_t*)dst->ch[i], (const int16_t*)src->ch[i], consumed, src_size, dst_size, i+1==dst->ch_count);
         else if(c->format == AV_SAMPLE_FMT_S32P) ret= swri_resample_int32(c, (int32_t*)dst->ch[i], (const int32_t*)src->ch[i], consumed, src_size, dst_size, i+1==dst->ch_count);
@@ -25,8 +25,8 @@
  * @author Michael Niedermayer <michaelni@gmx.at>
  */
 
-#if defined(TEMPLATE_RESAMPLE_DBL)
-#    define RENAME(N) N ## _double
+#if      defined(TEMPLATE_RESAMPLE_DBL) \
+      || defined(TEMPLATE_RESAMPLE_DBL_NEON)
 #    define FILTER_SHIFT 0
 #    define DELEM  double
 #    define FELEM  double
@@ -34,8 +34,16 @@
 #    define FELEML double
 #    define OUT(d, v) d = v
 
-#elif defined(TEMPLATE_RESAMPLE_FLT)
-#    define RENAME(N) N ## _float
+#    if defined(TEMPLATE_RESAMPLE_DBL)
+#        define RENAME(N) N ## _double
+#    elif defined(TEMPLATE_RESAMPLE_DBL_NEON)
+#        define COMMON_CORE COMMON_CORE_NEON(double)
+#        define LINEAR_CORE LINEAR_CORE_NEON(double)
+#        define RENAME(N) N ## _double_neon
+#    endif
+
+#elif    defined(TEMPLATE_RESAMPLE_FLT) \
+      || defined(TEMPLATE_RESAMPLE_FLT_NEON)
 #    define FILTER_SHIFT 0
 #    define DELEM  float
 #    define FELEM  float
@@ -43,8 +51,16 @@
 #    define FELEML float
 #    define OUT(d, v) d = v
 
-#elif defined(TEMPLATE_RESAMPLE_S32)
-#    define RENAME(N) N ## _int32
+#    if defined(TEMPLATE_RESAMPLE_FLT)
+#        define RENAME(N) N ## _float
+#    elif defined(TEMPLATE_RESAMPLE_FLT_NEON)
+#        define COMMON_CORE COMMON_CORE_NEON(float)
+#        define LINEAR_CORE LINEAR_CORE_NEON(float)
+#        define RENAME(N) N ## _float_neon
+#    endif
+
+#elif    defined(TEMPLATE_RESAMPLE_S32) \
+      || defined(TEMPLATE_RESAMPLE_S32_NEON)
 #    define FILTER_SHIFT 30
 #    define DELEM  int32_t
 #    define FELEM  int32_t
@@ -55,9 +71,18 @@
 #    define OUT(d, v) v = (v + (1<<(FILTER_SHIFT-1)))>>FILTER_SHIFT;\
                       d = (uint64_t)(v + 0x80000000) > 0xFFFFFFFF ? (v>>63) ^ 0x7FFFFFFF : v
 
-#elif    defined(TEMPLATE_RESAMPLE_S16)      \
-      || defined(TEMPLATE_RESAMPLE_S16_MMX2) \
-      || defined(TEMPLATE_RESAMPLE_S16_SSSE3)
+#    if defined(TEMPLATE_RESAMPLE_S32)
+#        define RENAME(N) N ## _int32
+#    elif defined(TEMPLATE_RESAMPLE_S32_NEON)
+#        define COMMON_CORE COMMON_CORE_NEON(int32)
+#        define LINEAR_CORE LINEAR_CORE_NEON(int32)
+#        define RENAME(N) N ## _int32_neon
+#    endif
+
+#elif    defined(TEMPLATE_RESAMPLE_S16)       \
+      || defined(TEMPLATE_RESAMPLE_S16_MMX2)  \
+      || defined(TEMPLATE_RESAMPLE_S16_SSSE3) \
+      || defined(TEMPLATE_RESAMPLE_S16_NEON)
 
 #    define FILTER_SHIFT 15
 #    define DELEM  int16_t
@@ -77,6 +102,10 @@
 #    elif defined(TEMPLATE_RESAMPLE_S16_SSSE3)
 #        define COMMON_CORE COMMON_CORE_INT16_SSSE3
 #        define RENAME(N) N ## _int16_ssse3
+#    elif defined(TEMPLATE_RESAMPLE_S16_NEON)
+#        define COMMON_CORE COMMON_CORE_NEON(int16)
+#        define LINEAR_CORE LINEAR_CORE_NEON(int16)
+#        define RENAME(N) N ## _int16_neon
 #    endif
 
 #endif
@@ -153,12 +182,16 @@ int RENAME(swri_resample)(ResampleContext *c, DELEM *dst, const DELEM *src, int
                 for(i=0; i<c->filter_length; i++)
                     val += src[FFABS(sample_index + i)] * (FELEM2)filter[i];
             }else if(c->linear){
+#ifdef LINEAR_CORE
+                LINEAR_CORE
+#else
                 FELEM2 v2=0;
                 for(i=0; i<c->filter_length; i++){
                     val += src[sample_index + i] * (FELEM2)filter[i];
                     v2  += src[sample_index + i] * (FELEM2)filter[i + c->filter_alloc];
                 }
                 val+=(v2-val)*(FELEML)frac / c->src_incr;
+#endif
             }else{
                 for(i=0; i<c->filter_length; i++){
                     val += src[sample_index + i] * (FELEM2)filter[i];
@@ -200,6 +233,7 @@ int RENAME(swri_resample)(ResampleContext *c, DELEM *dst, const DELEM *src, int
 }
 
 #undef COMMON_CORE
+#undef LINEAR_CORE
 #undef RENAME
 #undef FILTER_SHIFT
 #undef DELEM
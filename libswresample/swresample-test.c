@@ -22,6 +22,7 @@
 #include "libavutil/avassert.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/common.h"
+#include "libavutil/cpu.h"
 #include "libavutil/opt.h"
 #include "swresample.h"
 
@@ -219,6 +220,86 @@ static void audiogen(void *data, enum AVSampleFormat sample_fmt,
     }
 }
 
+/**
+ * Convert SAMPLES input samples in two calls, so that the second one starts
+ * past the filter delay and runs the main loop of the resampler.
+ */
+static int convert_split(uint8_t *out[], uint64_t out_ch_layout, enum AVSampleFormat out_sample_fmt, int out_sample_rate,
+                         uint8_t *in[], uint64_t  in_ch_layout, enum AVSampleFormat  in_sample_fmt, int  in_sample_rate,
+                         int linear){
+    struct SwrContext *ctx;
+    uint8_t *ain [SWR_CH_MAX];
+    uint8_t *aout[SWR_CH_MAX];
+    int  in_ch_count= av_get_channel_layout_nb_channels( in_ch_layout);
+    int out_ch_count= av_get_channel_layout_nb_channels(out_ch_layout);
+    int count, ret;
+
+    ctx = swr_alloc_set_opts(NULL, out_ch_layout, out_sample_fmt, out_sample_rate,
+                                    in_ch_layout,  in_sample_fmt,  in_sample_rate,
+                             0, 0);
+    if(ctx)
+        av_opt_set_int(ctx, "linear_interp", linear, 0);
+    if(!ctx || swr_init(ctx) < 0){
+        swr_free(&ctx);
+        return -1;
+    }
+    memcpy(ain , in , sizeof(ain));
+    memcpy(aout, out, sizeof(aout));
+    count= swr_convert(ctx, aout, 3*SAMPLES, (const uint8_t **)ain, SAMPLES/4);
+    if(count >= 0){
+        shift(ain , SAMPLES/4, in_ch_count,  in_sample_fmt);
+        shift(aout, count    , out_ch_count, out_sample_fmt);
+        ret= swr_convert(ctx, aout, 3*SAMPLES - count, (const uint8_t **)ain, SAMPLES - SAMPLES/4);
+        count= ret < 0 ? ret : count + ret;
+    }
+    swr_free(&ctx);
+    return count;
+}
+
+/**
+ * Compare the forward conversion done with the SIMD functions enabled
+ * against the same conversion done by the C code alone, with and without
+ * linear interpolation between the filter phases.
+ */
+static void compare_simd(uint64_t out_ch_layout, enum AVSampleFormat out_sample_fmt, int out_sample_rate,
+                         uint64_t  in_ch_layout, enum AVSampleFormat  in_sample_fmt, int  in_sample_rate,
+                         uint8_t *ain[]){
+    static uint8_t array_simd[SAMPLES*8*8*3];
+    static uint8_t array_c   [SAMPLES*8*8*3];
+    uint8_t *asimd[SWR_CH_MAX];
+    uint8_t *ac   [SWR_CH_MAX];
+    int out_ch_count= av_get_channel_layout_nb_channels(out_ch_layout);
+    int cpu_flags= av_get_cpu_flags();
+    int simd_count, c_count, ch, i, linear;
+
+    if(!cpu_flags)
+        return;
+
+    for(linear=0; linear<2; linear++){
+        double maxdiff= 0;
+
+        setup_array(asimd, array_simd, out_sample_fmt, 3*SAMPLES);
+        setup_array(ac   , array_c   , out_sample_fmt, 3*SAMPLES);
+
+        simd_count= convert_split(asimd, out_ch_layout, out_sample_fmt, out_sample_rate,
+                                  ain, in_ch_layout, in_sample_fmt, in_sample_rate, linear);
+        av_force_cpu_flags(0);
+        c_count   = convert_split(ac   , out_ch_layout, out_sample_fmt, out_sample_rate,
+                                  ain, in_ch_layout, in_sample_fmt, in_sample_rate, linear);
+        av_force_cpu_flags(cpu_flags);
+
+        if(simd_count != c_count){
+            fprintf(stderr, "simd/C length mismatch: %d != %d\n", simd_count, c_count);
+            continue;
+        }
+        for(ch=0; ch<out_ch_count; ch++)
+            for(i=0; i<c_count; i++)
+                maxdiff= FFMAX(maxdiff, FFABS(get(asimd, ch, i, out_ch_count, out_sample_fmt) -
+                                              get(ac   , ch, i, out_ch_count, out_sample_fmt)));
+        fprintf(stderr, "[simd%s max:%g] len:%5d\n", linear ? " linear" : "", maxdiff, c_count);
+    }
+}
+
 int main(int argc, char **argv){
     int in_sample_rate, out_sample_rate, ch ,i, flush_count;
     uint64_t in_ch_layout, out_ch_layout;
@@ -352,6 +433,9 @@ int main(int argc, char **argv){
         }
         out_count= swr_convert(backw_ctx,aout, SAMPLES, (const uint8_t **)amid, mid_count);
 
+        compare_simd(out_ch_layout, out_sample_fmt, out_sample_rate,
+                      in_ch_layout,  in_sample_fmt,  in_sample_rate, ain);
+
         for(ch=0; ch<in_ch_count; ch++){
             double sse, maxdiff=0;
             double sum_a= 0;
@@ -0,0 +1,55 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/arm/cpu.h"
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+void ff_hscale_8_to_15_neon(SwsContext *c, int16_t *dst, int dstW,
+                            const uint8_t *src, const int16_t *filter,
+                            const int32_t *filterPos, int filterSize);
+
+void ff_yuv2planeX_8_neon(const int16_t *filter, int filterSize,
+                          const int16_t **src, uint8_t *dest, int dstW,
+                          const uint8_t *dither, int offset);
+void ff_yuv2plane1_8_neon(const int16_t *src, uint8_t *dest, int dstW,
+                          const uint8_t *dither, int offset);
+
+av_cold void ff_sws_init_swScale_arm(SwsContext *c)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (have_neon(cpu_flags)) {
+        /* the horizontal scaler consumes 4 taps per iteration and reads
+         * them as whole words, so the source must be at least that wide */
+        if (c->srcBpc == 8 && c->dstBpc <= 14) {
+            if (!(c->hLumFilterSize & 3) && c->srcW >= c->hLumFilterSize)
+                c->hyScale = ff_hscale_8_to_15_neon;
+            if (!(c->hChrFilterSize & 3) && c->chrSrcW >= c->hChrFilterSize)
+                c->hcScale = ff_hscale_8_to_15_neon;
+        }
+        if (c->dstBpc == 8) {
+            c->yuv2planeX = ff_yuv2planeX_8_neon;
+            c->yuv2plane1 = ff_yuv2plane1_8_neon;
+        }
+    }
+}
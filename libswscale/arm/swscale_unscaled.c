@@ -0,0 +1,176 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/arm/cpu.h"
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+typedef void (*yuv2rgb_row_fn)(uint8_t *dst, const uint8_t *y,
+                               const uint8_t *u, const uint8_t *v,
+                               int width, const int16_t *coeffs,
+                               const uint8_t *dither);
+
+void ff_yuv420p_to_rgba_row_neon(uint8_t *dst, const uint8_t *y,
+                                 const uint8_t *u, const uint8_t *v,
+                                 int width, const int16_t *coeffs,
+                                 const uint8_t *dither);
+void ff_yuv420p_to_bgra_row_neon(uint8_t *dst, const uint8_t *y,
+                                 const uint8_t *u, const uint8_t *v,
+                                 int width, const int16_t *coeffs,
+                                 const uint8_t *dither);
+void ff_yuv420p_to_rgb565_row_neon(uint8_t *dst, const uint8_t *y,
+                                   const uint8_t *u, const uint8_t *v,
+                                   int width, const int16_t *coeffs,
+                                   const uint8_t *dither);
+
+/* same ordered dither as the MMX rgb565 converter */
+static const uint8_t dither4[2][8] = {
+    { 3, 1, 3, 1, 3, 1, 3, 1 },
+    { 0, 2, 0, 2, 0, 2, 0, 2 },
+};
+
+static const uint8_t dither8[2][8] = {
+    { 2, 6, 2, 6, 2, 6, 2, 6 },
+    { 4, 0, 4, 0, 4, 0, 4, 0 },
+};
+
+/**
+ * Convert YUV420P to packed RGB with the fixed point coefficients of
+ * the MMX converter. The NEON function handles the line in blocks of 16
+ * pixels, the remaining ones are converted here with the same arithmetic.
+ */
+static av_always_inline int yuv420p_to_rgb(SwsContext *c, const uint8_t *src[],
+                                           int srcStride[], int srcSliceY,
+                                           int srcSliceH, uint8_t *dst[],
+                                           int dstStride[], yuv2rgb_row_fn row,
+                                           enum AVPixelFormat dstFormat)
+{
+    DECLARE_ALIGNED(16, int16_t, coeffs)[8];
+    DECLARE_ALIGNED(8, uint8_t, dither)[24];
+    int width = c->dstW;
+    int w16   = width & ~15;
+    int y;
+
+    coeffs[0] = c->yOffset;
+    coeffs[1] = c->uOffset;
+    coeffs[2] = c->vOffset;
+    coeffs[3] = c->yCoeff;
+    coeffs[4] = c->ubCoeff;
+    coeffs[5] = c->vrCoeff;
+    coeffs[6] = c->ugCoeff;
+    coeffs[7] = c->vgCoeff;
+
+    for (y = 0; y < srcSliceH; y++) {
+        uint8_t *image    = dst[0] + (y + srcSliceY) * dstStride[0];
+        const uint8_t *py = src[0] +              y * srcStride[0];
+        const uint8_t *pu = src[1] +       (y >> 1) * srcStride[1];
+        const uint8_t *pv = src[2] +       (y >> 1) * srcStride[2];
+        int line = y + srcSliceY;
+        int x;
+
+        memcpy(dither,      dither8[(line + 1) & 1], 8);
+        memcpy(dither + 8,  dither4[ line      & 1], 8);
+        memcpy(dither + 16, dither8[ line      & 1], 8);
+
+        if (w16)
+            row(image, py, pu, pv, w16, coeffs, dither);
+
+        for (x = w16; x < width; x++) {
+            int Y  = (py[x] << 3) - coeffs[0];
+            int U  = av_clip_int16((pu[x >> 1] << 3) - coeffs[1]);
+            int V  = av_clip_int16((pv[x >> 1] << 3) - coeffs[2]);
+            int cg = av_clip_int16((U * coeffs[6] >> 16) + (V * coeffs[7] >> 16));
+            int r, g, b;
+
+            Y = Y * coeffs[3] >> 16;
+            r = av_clip_uint8(Y + (V * coeffs[5] >> 16));
+            g = av_clip_uint8(Y + cg);
+            b = av_clip_uint8(Y + (U * coeffs[4] >> 16));
+
+            switch (dstFormat) {
+            case AV_PIX_FMT_RGB565:
+                r = FFMIN(r + dither[     (x & 7)], 255);
+                g = FFMIN(g + dither[ 8 + (x & 7)], 255);
+                b = FFMIN(b + dither[16 + (x & 7)], 255);
+                AV_WN16(image + 2 * x, (r >> 3) << 11 | (g >> 2) << 5 | b >> 3);
+                break;
+            case AV_PIX_FMT_RGBA:
+                AV_WN32(image + 4 * x, MKTAG(r, g, b, 255));
+                break;
+            case AV_PIX_FMT_BGRA:
+                AV_WN32(image + 4 * x, MKTAG(b, g, r, 255));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    return srcSliceH;
+}
+
+#define YUV420P_TO_RGB_WRAPPER(name, fmt)                                   \
+static int yuv420p_to_ ## name ## _neon_wrapper(SwsContext *c,              \
+                                                const uint8_t *src[],       \
+                                                int srcStride[],            \
+                                                int srcSliceY,              \
+                                                int srcSliceH,              \
+                                                uint8_t *dst[],             \
+                                                int dstStride[])            \
+{                                                                           \
+    return yuv420p_to_rgb(c, src, srcStride, srcSliceY, srcSliceH,          \
+                          dst, dstStride,                                   \
+                          ff_yuv420p_to_ ## name ## _row_neon, fmt);        \
+}
+
+YUV420P_TO_RGB_WRAPPER(rgba,   AV_PIX_FMT_RGBA)
+YUV420P_TO_RGB_WRAPPER(bgra,   AV_PIX_FMT_BGRA)
+YUV420P_TO_RGB_WRAPPER(rgb565, AV_PIX_FMT_RGB565)
+
+av_cold void ff_get_unscaled_swscale_arm(SwsContext *c)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    /* the NEON converter uses the lower precision arithmetic of the MMX
+     * one, so it is not bitexact with the C converter */
+    if (!have_neon(cpu_flags) ||
+        c->srcFormat != AV_PIX_FMT_YUV420P || (c->dstH & 1) ||
+        c->flags & (SWS_ACCURATE_RND | SWS_ERROR_DIFFUSION | SWS_BITEXACT))
+        return;
+
+    switch (c->dstFormat) {
+    case AV_PIX_FMT_RGBA:
+        c->swScale = yuv420p_to_rgba_neon_wrapper;
+        break;
+    case AV_PIX_FMT_BGRA:
+        c->swScale = yuv420p_to_bgra_neon_wrapper;
+        break;
+    case AV_PIX_FMT_RGB565:
+        c->swScale = yuv420p_to_rgb565_neon_wrapper;
+        break;
+    default:
+        break;
+    }
+}
@@ -443,7 +443,7 @@ static int swScale(SwsContext *c, const uint8_t *src[],
     if (srcSliceY == 0) {
         lumBufIndex  = -1;
         chrBufIndex  = -1;
-        dstY         = 0;
+        dstY         = c->dstSliceStart;
         lastInLumBuf = -1;
         lastInChrBuf = -1;
     }
@@ -453,7 +453,7 @@ static int swScale(SwsContext *c, const uint8_t *src[],
     }
     lastDstY = dstY;
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < c->dstSliceEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         uint8_t *dest[4]  = {
             dst[0] + dstStride[0] * dstY,
@@ -763,6 +763,8 @@ SwsFunc ff_getSwsFunc(SwsContext *c)
         ff_sws_init_swScale_mmx(c);
     if (HAVE_ALTIVEC)
         ff_sws_init_swScale_altivec(c);
+    if (ARCH_ARM)
+        ff_sws_init_swScale_arm(c);
 
     return swScale;
 }
@@ -850,6 +852,130 @@ static void xyz12Torgb48(struct SwsContext *c, uint16_t *dst,
     }
 }
 
+static void scale_band(void *priv, int jobnr, int threadnr,
+                       int nb_jobs, int nb_threads)
+{
+    SwsContext *parent = priv;
+    SwsContext *c      = parent->slice_ctx[jobnr];
+    const uint8_t *src[4];
+    uint8_t *dst[4];
+    int srcStride[4], dstStride[4];
+
+    /* swScale() modifies the pointer and stride arrays */
+    memcpy(src,       parent->frame_src,       sizeof(src));
+    memcpy(dst,       parent->frame_dst,       sizeof(dst));
+    memcpy(srcStride, parent->frame_srcStride, sizeof(srcStride));
+    memcpy(dstStride, parent->frame_dstStride, sizeof(dstStride));
+
+    c->swScale(c, src, srcStride, 0, c->srcH, dst, dstStride);
+}
+
+/* Never split the output into bands shorter than this, the source lines
+ * covered by the vertical filter at the band edges are scaled twice. */
+#define MIN_BAND_HEIGHT 16
+
+static void init_slice_threads(SwsContext *c)
+{
+    int i, nb_threads, nb_bands;
+    int align = 1 << c->chrDstVSubSample;
+
+    c->slice_thread_init = 1;
+    if (!c->can_slice_thread || c->nb_threads == 1 ||
+        c->dstH < 2 * MIN_BAND_HEIGHT)
+        return;
+
+    nb_threads = avpriv_slicethread_create(&c->slicethread, c, scale_band,
+                                           c->nb_threads);
+    if (nb_threads < 0) {
+        if (nb_threads != AVERROR(ENOSYS))
+            av_log(c, AV_LOG_WARNING, "Could not create the scaling threads\n");
+        return;
+    }
+    nb_bands = FFMIN(nb_threads, c->dstH / MIN_BAND_HEIGHT);
+
+    c->slice_ctx = av_mallocz(nb_bands * sizeof(*c->slice_ctx));
+    if (!c->slice_ctx)
+        goto fail;
+
+    for (i = 0; i < nb_bands; i++) {
+        SwsContext *s = sws_alloc_context();
+        if (!s)
+            goto fail;
+        c->slice_ctx[c->nb_slice_ctx++] = s;
+
+        s->srcW       = c->srcW;
+        s->srcH       = c->srcH;
+        s->dstW       = c->dstW;
+        s->dstH       = c->dstH;
+        s->srcFormat  = c->srcFormat;
+        s->dstFormat  = c->dstFormat;
+        s->flags      = c->flags & ~SWS_PRINT_INFO;
+        s->param[0]   = c->param[0];
+        s->param[1]   = c->param[1];
+        s->src0Alpha  = c->src0Alpha;
+        s->dst0Alpha  = c->dst0Alpha;
+        s->srcXYZ     = c->srcXYZ;
+        s->dstXYZ     = c->dstXYZ;
+        s->nb_threads = 1;
+        sws_setColorspaceDetails(s, c->srcColorspaceTable, c->srcRange,
+                                 c->dstColorspaceTable, c->dstRange,
+                                 c->brightness, c->contrast, c->saturation);
+        /* the default table is identified by address, copy the result */
+        memcpy(s->input_rgb2yuv_table, c->input_rgb2yuv_table,
+               sizeof(c->input_rgb2yuv_table));
+        if (sws_init_context(s, NULL, NULL) < 0 || s->swScale != c->swScale)
+            goto fail;
+
+        /* bands must start on a line carrying chroma */
+        s->dstSliceStart = (int)((int64_t)c->dstH * i / nb_bands) & ~(align - 1);
+        s->dstSliceEnd   = i == nb_bands - 1 ? c->dstH :
+                           (int)((int64_t)c->dstH * (i + 1) / nb_bands) & ~(align - 1);
+    }
+    return;
+
+fail:
+    av_log(c, AV_LOG_WARNING, "Could not initialize threaded scaling\n");
+    avpriv_slicethread_free(&c->slicethread);
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_freeContext(c->slice_ctx[i]);
+    av_freep(&c->slice_ctx);
+    c->nb_slice_ctx = 0;
+}
+
+/**
+ * Scale a slice, splitting it among the band contexts if it is a whole
+ * frame and threading is enabled.
+ */
+static int scale_internal(SwsContext *c, const uint8_t *src[], int srcStride[],
+                          int srcSliceY, int srcSliceH, uint8_t *dst[],
+                          int dstStride[])
+{
+    int i;
+
+    if (srcSliceY || srcSliceH != c->srcH)
+        return c->swScale(c, src, srcStride, srcSliceY, srcSliceH, dst, dstStride);
+
+    if (!c->slice_thread_init)
+        init_slice_threads(c);
+    if (!c->nb_slice_ctx)
+        return c->swScale(c, src, srcStride, srcSliceY, srcSliceH, dst, dstStride);
+
+    memcpy(c->frame_src,       src,       sizeof(c->frame_src));
+    memcpy(c->frame_dst,       dst,       sizeof(c->frame_dst));
+    memcpy(c->frame_srcStride, srcStride, sizeof(c->frame_srcStride));
+    memcpy(c->frame_dstStride, dstStride, sizeof(c->frame_dstStride));
+    if (usePal(c->srcFormat)) {
+        for (i = 0; i < c->nb_slice_ctx; i++) {
+            memcpy(c->slice_ctx[i]->pal_yuv, c->pal_yuv, sizeof(c->pal_yuv));
+            memcpy(c->slice_ctx[i]->pal_rgb, c->pal_rgb, sizeof(c->pal_rgb));
+        }
+    }
+
+    avpriv_slicethread_execute(c->slicethread, c->nb_slice_ctx);
+
+    return c->dstH;
+}
+
 /**
  * swscale wrapper, so we don't need to export the SwsContext.
  * Assumes planar YUV to be in YUV order instead of YVU.
@@ -1016,8 +1142,8 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
         if (srcSliceY + srcSliceH == c->srcH)
             c->sliceDir = 0;
 
-        ret = c->swScale(c, src2, srcStride2, srcSliceY, srcSliceH, dst2,
-                          dstStride2);
+        ret = scale_internal(c, src2, srcStride2, srcSliceY, srcSliceH, dst2,
+                             dstStride2);
     } else {
         // slices go from bottom to top => we flip the image internally
         int srcStride2[4] = { -srcStride[0], -srcStride[1], -srcStride[2],
@@ -1042,8 +1168,8 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
         if (!srcSliceY)
             c->sliceDir = 0;
 
-        ret = c->swScale(c, src2, srcStride2, c->srcH-srcSliceY-srcSliceH,
-                          srcSliceH, dst2, dstStride2);
+        ret = scale_internal(c, src2, srcStride2, c->srcH-srcSliceY-srcSliceH,
+                             srcSliceH, dst2, dstStride2);
     }
 
     av_free(rgb0_tmp);
@@ -34,6 +34,7 @@
 #include "libavutil/log.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/slicethread.h"
 
 #define STR(s) AV_TOSTRING(s) // AV_STRINGIFY is too long
 
@@ -292,6 +293,27 @@ typedef struct SwsContext {
     uint32_t pal_yuv[256];
     uint32_t pal_rgb[256];
 
+    /**
+     * @name Slice threading.
+     * A whole frame passed to sws_scale() can be split into horizontal bands
+     * of the destination image, each one scaled by its own context in
+     * slice_ctx on a thread of the slicethread pool.
+     */
+    //@{
+    int nb_threads;               ///< Number of threads requested by the user, 0 for automatic.
+    int can_slice_thread;         ///< Set by sws_init_context() if bands of the output can be scaled independently.
+    int slice_thread_init;        ///< Set once creating the band contexts has been attempted.
+    AVSliceThread *slicethread;
+    struct SwsContext **slice_ctx;
+    int nb_slice_ctx;
+    int dstSliceStart;            ///< First destination line output by this context.
+    int dstSliceEnd;              ///< Destination line after the last one output by this context.
+    const uint8_t *frame_src[4];  ///< Source planes of the frame scaled by the band contexts.
+    int frame_srcStride[4];
+    uint8_t *frame_dst[4];        ///< Destination planes of the frame scaled by the band contexts.
+    int frame_dstStride[4];
+    //@}
+
     /**
      * @name Scaled horizontal lines ring buffer.
      * The horizontal scaler keeps just enough scaled lines in a ring buffer
@@ -808,6 +830,7 @@ extern const AVClass sws_context_class;
 void ff_get_unscaled_swscale(SwsContext *c);
 
 void ff_swscale_get_unscaled_altivec(SwsContext *c);
+void ff_get_unscaled_swscale_arm(SwsContext *c);
 
 /**
  * Return function pointer to fastest main scaler path function depending
@@ -826,6 +849,7 @@ void ff_sws_init_output_funcs(SwsContext *c,
                               yuv2anyX_fn *yuv2anyX);
 void ff_sws_init_swScale_altivec(SwsContext *c);
 void ff_sws_init_swScale_mmx(SwsContext *c);
+void ff_sws_init_swScale_arm(SwsContext *c);
 
 static inline void fillPlane16(uint8_t *plane, int stride, int width, int height, int y,
                                int alpha, int bits, const int big_endian)
@@ -1165,6 +1165,8 @@ void ff_get_unscaled_swscale(SwsContext *c)
         ff_bfin_get_unscaled_swscale(c);
     if (HAVE_ALTIVEC)
         ff_swscale_get_unscaled_altivec(c);
+    if (ARCH_ARM)
+        ff_get_unscaled_swscale_arm(c);
 }
 
 /* Convert the palette to the same packed 32-bit format as the palette */
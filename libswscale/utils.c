@@ -938,6 +938,12 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
 {
     const AVPixFmtDescriptor *desc_dst = av_pix_fmt_desc_get(c->dstFormat);
     const AVPixFmtDescriptor *desc_src = av_pix_fmt_desc_get(c->srcFormat);
+    int i;
+
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_setColorspaceDetails(c->slice_ctx[i], inv_table, srcRange, table,
+                                 dstRange, brightness, contrast, saturation);
+
     memcpy(c->srcColorspaceTable, inv_table, sizeof(int) * 4);
     memcpy(c->dstColorspaceTable, table, sizeof(int) * 4);
 
@@ -1123,6 +1129,9 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
         return AVERROR(EINVAL);
     }
 
+    c->dstSliceStart = 0;
+    c->dstSliceEnd   = dstH;
+
     if (!dstFilter)
         dstFilter = &dummyFilter;
     if (!srcFilter)
@@ -1363,6 +1372,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
             const int filterAlign =
                 (HAVE_MMX && cpu_flags & AV_CPU_FLAG_MMX) ? 4 :
                 (HAVE_ALTIVEC && cpu_flags & AV_CPU_FLAG_ALTIVEC) ? 8 :
+                (HAVE_NEON    && cpu_flags & AV_CPU_FLAG_NEON)    ? 4 :
                 1;
 
             if (initFilter(&c->hLumFilter, &c->hLumFilterPos,
@@ -1548,6 +1558,12 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                c->chrXInc, c->chrYInc);
     }
 
+    /* The band contexts used for slice threading are created with default
+     * filters; error diffusion dithering carries state from line to line. */
+    c->can_slice_thread = srcFilter == &dummyFilter &&
+                          dstFilter == &dummyFilter &&
+                          !(flags & SWS_ERROR_DIFFUSION);
+
     c->swScale = ff_getSwsFunc(c);
     return 0;
 fail: // FIXME replace things by appropriate error codes
@@ -1921,6 +1937,11 @@ void sws_freeContext(SwsContext *c)
     if (!c)
         return;
 
+    avpriv_slicethread_free(&c->slicethread);
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_freeContext(c->slice_ctx[i]);
+    av_freep(&c->slice_ctx);
+
     if (c->lumPixBuf) {
         for (i = 0; i < c->vLumBufSize; i++)
             av_freep(&c->lumPixBuf[i]);
@@ -39,6 +39,13 @@ fate-vc1_sa10143: CMD = framecrc -i $(SAMPLES)/vc1/SA10143.vc1
 FATE_VC1-$(CONFIG_VC1_DEMUXER) += fate-vc1_sa20021
 fate-vc1_sa20021: CMD = framecrc -i $(SAMPLES)/vc1/SA20021.vc1
 
+# frame threads must decode the same frames as a single thread
+FATE_VC1-$(CONFIG_VC1_DEMUXER) += fate-vc1_sa00050-thread
+fate-vc1_sa00050-thread: CMD = framecrc -threads 4 -thread_type frame -i $(SAMPLES)/vc1/SA00050.vc1
+
+FATE_VC1-$(CONFIG_VC1_DEMUXER) += fate-vc1_sa10091-thread
+fate-vc1_sa10091-thread: CMD = framecrc -threads 4 -thread_type frame -i $(SAMPLES)/vc1/SA10091.vc1
+
 FATE_VC1-$(CONFIG_MOV_DEMUXER) += fate-vc1-ism
 fate-vc1-ism: CMD = framecrc -i $(SAMPLES)/isom/vc1-wmapro.ism -an
 
@@ -54,10 +54,13 @@ fate-vsynth%-dv-50:              ENCOPTS = -dct int -s pal -pix_fmt yuv422p \
 fate-vsynth%-dv-50:              DECOPTS = -sws_flags neighbor
 fate-vsynth%-dv-50:              FMT     = dv
 
-FATE_VCODEC-$(call ENCDEC, FFV1, AVI)   += ffv1
+FATE_VCODEC-$(call ENCDEC, FFV1, AVI)   += ffv1 ffv1-thread
 fate-vsynth%-ffv1:               ENCOPTS = -slices 4 -strict -2
+fate-vsynth%-ffv1-thread:        ENCOPTS = -slices 4 -strict -2 -g 1 \
+                                           -threads 4 -thread_type frame
 
-FATE_VCODEC-$(call ENCDEC, FFVHUFF, AVI) += ffvhuff
+FATE_VCODEC-$(call ENCDEC, FFVHUFF, AVI) += ffvhuff ffvhuff-thread
+fate-vsynth%-ffvhuff-thread:     ENCOPTS = -threads 4 -thread_type frame
 
 FATE_VCODEC-$(call ENCDEC, FLASHSV, FLV) += flashsv
 fate-vsynth%-flashsv:            ENCOPTS = -sws_flags neighbor+full_chroma_int
@@ -197,8 +200,10 @@ fate-vsynth%-msmpeg4:            ENCOPTS = -qscale 10
 FATE_VCODEC-$(call ENCDEC, MSMPEG4V2, AVI) += msmpeg4v2
 fate-vsynth%-msmpeg4v2:          ENCOPTS = -qscale 10
 
-FATE_VCODEC-$(call ENCDEC, PNG, AVI)    += mpng
+FATE_VCODEC-$(call ENCDEC, PNG, AVI)    += mpng mpng-thread
 fate-vsynth%-mpng:               CODEC   = png
+fate-vsynth%-mpng-thread:        CODEC   = png
+fate-vsynth%-mpng-thread:        ENCOPTS = -threads 4 -thread_type frame
 
 FATE_VCODEC-$(call ENCDEC, MSVIDEO1, AVI) += msvideo1
 